@@ -22,8 +22,25 @@
 
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <avr/sleep.h>
 #include <Arduino.h>
 #include <Synth.h>
+#if SYNTH__WAVETABLES
+	// Defines SYNTH__WAVE_TABLE_BITS. The table size can only get changed by
+	// regenerating this file using "resources/scripts/waves.php".
+	#include <SynthWaveTables.h>
+#else
+	#define SYNTH__WAVE_TABLE_BITS	8
+#endif
+
+// The period index has 10 bits (1024 steps). This is the number of bits which
+// have to get shifted out to get the index into a wave table.
+#define SYNTH__WAVE_TABLE_SHIFT	( 10 - SYNTH__WAVE_TABLE_BITS )
+#define SYNTH__WAVE_TABLE_MASK	( ( 1 << SYNTH__WAVE_TABLE_BITS ) - 1 )
+
+// Keeps the compiler from moving memory accesses across this point. Used for
+// the event queue which gets accessed by the ISR and the sketch without locking.
+#define SYNTH__MEMORY_BARRIER()	asm volatile ("" ::: "memory")
 
 /**
  * This synthesizer library for the Arduino uses the PWM feature of the
@@ -32,12 +49,23 @@
  * frequency window this library is intended to synthesize only frequencies
  * of notes within the MIDI note range.
  *
- * The audio sampling frequency is hardcoded to 12.5 kHz. Thus according
+ * The audio sampling frequency is 12.5 kHz by default. Thus according
  * to the discrete-signal-theorem the maximum frequency to generate will
  * be 6.25 kHz. The last note in the MIDI note range which falls within
  * this range is the note with index 114 with a frequency of 5919.91076 Hz.
- * So every note above this value (MIDI notes 115 - 127) will most probably
- * not get played correctly.
+ * So every note above this value (MIDI notes 115 - 127) can not get played
+ * and gets muted instead of being played at a wrong (aliased) frequency.
+ *
+ * Songs with fewer tracks do not need all of the CPU time available. So
+ * for those a higher sampling frequency of up to 31.25 kHz gets selected
+ * when a song starts. See "selectSampleRate".
+ *
+ * Next to the sine a square and a sawtooth waveform are available. Those
+ * contain harmonics which would exceed the maximum frequency for higher notes.
+ * So they are stored as a set of band-limited tables with one table per
+ * octave. When a note gets loaded the table with the most harmonics which all
+ * stay below the maximum frequency gets selected. Playing a sample then only
+ * takes a single table lookup.
  *
  * This implementation uses a precalculated sine lookup table and precalculated
  * sine table incrementation steps for the configured sampling frequency of
@@ -48,9 +76,10 @@
  * As a single PWM pulse would most probably not be sufficient to generate the
  * desired analog output value we assume it takes 5 PWM cycles for the output
  * to reach the desired analog value. So the sampling frequency is the PWM
- * frequency divided by 5 again. Using fewer PWM cycles could allow to achieve
- * a higher sampling frequency. But this would most probably only make sense
- * for more accurate external D/A converters.
+ * frequency divided by 5 again. Using fewer PWM cycles allows to achieve
+ * a higher sampling frequency which is done when the CPU time allows it. The
+ * RC filter then has less time to settle so some of the additional fidelity
+ * gets lost. But the aliasing of high notes gets reduced anyways.
  *
  * I started to write this synthesizer so I can play tunes like "Zum tanze da
  * geht ein Mädel" or "Der Mond ist aufgegangen" from the Arduino to my little
@@ -146,8 +175,8 @@ const byte SYNTH_sineTable[256] PROGMEM = {
 // An example: Take the note with index "7" (counted from 0). It has a periodBase of 1
 // and a period fraction of 1. Lets forget about the fraction so it has almost exactly
 // a periodBase of 1. This means when playing the note the internal logic will advance
-// by 1 step in above sineTable for every sample played. The sampling rate is hardcoded
-// at 12.5 kHz which equals a samplit period t_s of 80µs. The sineTable consists of 1024
+// by 1 step in above sineTable for every sample played. The default sampling rate is
+// 12.5 kHz which equals a samplit period t_s of 80µs. The sineTable consists of 1024
 // values. So it will take 1024*80µs for one full swing of the sine which equals a sine/note
 // period t_n of 81.92ms. The frequency of the sine is thus f= 1/t_n = ~ 12.21 Hz.
 // If you look up the frequency of the note "7" (G-2) in some MIDI frequency table you
@@ -159,26 +188,118 @@ const byte SYNTH_sineTable[256] PROGMEM = {
 // in the MIDI frequency table of "12.24985737443". I did never create a error calculation
 // for each note to see how much the largest error margin is but I can assume it is quite
 // small.
-const word SYNTH_periodBase[128] PROGMEM = {
-	0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
-	1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 
-	4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 8, 8, 9, 9, 10, 
-	10, 11, 12, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 24, 25, 
-	27, 28, 30, 32, 34, 36, 38, 40, 42, 45, 48, 50, 54, 57, 60, 64, 
-	68, 72, 76, 80, 85, 90, 96, 101, 108, 114, 121, 128, 136, 144, 152, 161, 
-	171, 181, 192, 203, 216, 228, 242, 256, 272, 288, 305, 323, 342, 363, 384, 407, 
-	432, 457, 484, 513, 544, 576, 611, 647, 685, 726, 769, 815, 864, 915, 969, 1027
- };
-const byte SYNTH_periodFraction[128] PROGMEM = { 
-	171, 182, 192, 204, 216, 229, 242, 1, 16, 32, 50, 68, 87, 107, 129, 152, 
-	176, 202, 229, 2, 32, 65, 99, 135, 174, 215, 2, 48, 96, 147, 202, 4, 
-	65, 129, 198, 15, 92, 173, 4, 95, 192, 39, 148, 7, 129, 3, 140, 29, 
-	183, 90, 7, 190, 128, 78, 40, 14, 3, 6, 24, 59, 111, 181, 15, 125, 
-	1, 156, 79, 29, 6, 11, 48, 117, 221, 106, 29, 250, 2, 56, 159, 57, 
-	11, 23, 96, 235, 187, 212, 58, 243, 3, 111, 61, 115, 22, 46, 193, 214, 
-	117, 168, 117, 230, 6, 223, 123, 230, 45, 92, 129, 172, 235, 79, 234, 205, 
-	13, 190, 246, 204, 89, 184, 3, 88, 214, 158, 211, 154, 25, 123, 235, 152
- };
+//
+// The tables exist once for every supported sampling frequency. The first one is for
+// 12.5 kHz (5 PWM cycles per sample) and every following one is for one PWM cycle less.
+const word SYNTH_periodBase[][128] PROGMEM = {
+	// 12.5 kHz
+	{
+		0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
+		1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 
+		4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 8, 8, 9, 9, 10, 
+		10, 11, 12, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 24, 25, 
+		27, 28, 30, 32, 34, 36, 38, 40, 42, 45, 48, 50, 54, 57, 60, 64, 
+		68, 72, 76, 80, 85, 90, 96, 101, 108, 114, 121, 128, 136, 144, 152, 161, 
+		171, 181, 192, 203, 216, 228, 242, 256, 272, 288, 305, 323, 342, 363, 384, 407, 
+		432, 457, 484, 513, 544, 576, 611, 647, 685, 726, 769, 815, 864, 915, 969, 1027
+	},
+	// 15.625 kHz
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 
+		1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 
+		3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 8, 
+		8, 9, 9, 10, 10, 11, 12, 12, 13, 14, 15, 16, 17, 18, 19, 20, 
+		21, 22, 24, 25, 27, 28, 30, 32, 34, 36, 38, 40, 43, 45, 48, 51, 
+		54, 57, 61, 64, 68, 72, 76, 81, 86, 91, 96, 102, 108, 115, 122, 129, 
+		137, 145, 153, 163, 172, 183, 193, 205, 217, 230, 244, 258, 274, 290, 307, 326, 
+		345, 366, 387, 411, 435, 461, 488, 517, 548, 581, 615, 652, 691, 732, 775, 822
+	},
+	// 20.833 kHz
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
+		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 
+		2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 6, 
+		6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 12, 12, 13, 14, 15, 
+		16, 17, 18, 19, 20, 21, 22, 24, 25, 27, 28, 30, 32, 34, 36, 38, 
+		40, 43, 45, 48, 51, 54, 57, 61, 64, 68, 72, 77, 81, 86, 91, 97, 
+		102, 108, 115, 122, 129, 137, 145, 154, 163, 173, 183, 194, 205, 217, 230, 244, 
+		259, 274, 290, 308, 326, 346, 366, 388, 411, 435, 461, 489, 518, 549, 581, 616
+	},
+	// 31.25 kHz
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
+		0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
+		1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 
+		4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 8, 8, 9, 9, 10, 
+		10, 11, 12, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 24, 25, 
+		27, 28, 30, 32, 34, 36, 38, 40, 43, 45, 48, 51, 54, 57, 61, 64, 
+		68, 72, 76, 81, 86, 91, 96, 102, 108, 115, 122, 129, 137, 145, 153, 163, 
+		172, 183, 193, 205, 217, 230, 244, 258, 274, 290, 307, 326, 345, 366, 387, 411
+	},
+};
+const byte SYNTH_periodFraction[][128] PROGMEM = {
+	// 12.5 kHz
+	{
+		171, 182, 192, 204, 216, 229, 242, 1, 16, 32, 50, 68, 87, 107, 129, 152, 
+		176, 202, 229, 2, 32, 65, 99, 135, 174, 215, 2, 48, 96, 147, 202, 4, 
+		65, 129, 198, 15, 92, 173, 4, 95, 192, 39, 148, 7, 129, 3, 140, 29, 
+		183, 90, 7, 190, 128, 78, 40, 14, 3, 6, 24, 59, 111, 181, 15, 125, 
+		1, 156, 79, 29, 6, 11, 48, 117, 221, 106, 29, 250, 2, 56, 159, 57, 
+		11, 23, 96, 235, 187, 212, 58, 243, 3, 111, 61, 115, 22, 46, 193, 214, 
+		117, 168, 117, 230, 6, 223, 123, 230, 45, 92, 129, 172, 235, 79, 234, 205, 
+		13, 190, 246, 204, 89, 184, 3, 88, 214, 158, 211, 154, 25, 123, 235, 152
+	},
+	// 15.625 kHz
+	{
+		137, 145, 154, 163, 173, 183, 194, 206, 218, 231, 244, 3, 18, 35, 52, 70, 
+		90, 110, 132, 155, 179, 205, 233, 6, 37, 69, 104, 140, 179, 220, 8, 54, 
+		103, 155, 210, 12, 73, 139, 208, 25, 103, 185, 16, 108, 206, 53, 163, 23, 
+		147, 21, 159, 50, 205, 114, 32, 216, 156, 107, 70, 47, 37, 42, 63, 100, 
+		154, 227, 63, 177, 56, 214, 141, 94, 75, 85, 126, 200, 52, 198, 127, 97, 
+		111, 172, 26, 188, 149, 169, 252, 143, 105, 140, 254, 194, 223, 88, 52, 120, 
+		43, 83, 247, 31, 210, 25, 252, 133, 189, 176, 103, 240, 86, 166, 238, 62, 
+		164, 49, 248, 9, 123, 96, 207, 224, 171, 75, 220, 123, 71, 98, 239, 19
+	},
+	// 20.833 kHz
+	{
+		103, 109, 115, 122, 130, 137, 145, 154, 163, 173, 183, 194, 206, 218, 231, 245, 
+		3, 19, 35, 52, 71, 90, 111, 132, 156, 180, 206, 233, 6, 37, 70, 105, 
+		141, 180, 221, 9, 55, 104, 156, 211, 13, 75, 140, 209, 26, 104, 186, 18, 
+		110, 208, 56, 165, 26, 149, 24, 162, 53, 208, 117, 35, 220, 160, 111, 75, 
+		52, 42, 48, 68, 106, 160, 234, 70, 184, 64, 222, 150, 103, 85, 95, 137, 
+		211, 65, 211, 141, 112, 127, 189, 44, 207, 169, 190, 18, 167, 130, 167, 26, 
+		224, 254, 121, 87, 157, 82, 125, 36, 78, 4, 78, 52, 192, 252, 243, 174, 
+		59, 165, 250, 71, 156, 8, 155, 104, 128, 248, 229, 92, 118, 74, 243, 142
+	},
+	// 31.25 kHz
+	{
+		69, 73, 77, 82, 86, 92, 97, 103, 109, 115, 122, 129, 137, 145, 154, 163, 
+		173, 183, 194, 206, 218, 231, 244, 3, 18, 35, 52, 70, 90, 110, 132, 155, 
+		179, 205, 233, 6, 37, 69, 104, 140, 179, 220, 8, 54, 103, 155, 210, 12, 
+		73, 139, 208, 25, 103, 185, 16, 108, 206, 53, 163, 23, 147, 21, 159, 50, 
+		205, 114, 32, 216, 156, 107, 70, 47, 37, 42, 63, 100, 154, 227, 63, 177, 
+		56, 214, 141, 94, 75, 85, 126, 200, 52, 198, 127, 97, 111, 172, 26, 188, 
+		149, 169, 252, 143, 105, 140, 254, 194, 223, 88, 52, 120, 43, 83, 247, 31, 
+		210, 25, 252, 133, 189, 176, 103, 240, 86, 166, 238, 62, 164, 49, 248, 9
+	},
+};
+
+// Pitch bend and fine tuning are done in steps of 1/16 semitone. An offset
+// of N 1/16 semitones above a note multiplies its increment by 2^(N/192).
+// This table contains (2^(N/192) - 1) * 65536 for N = 0 to 15 so the
+// increment of the note only has to get multiplied by the entry and the
+// high word of the product added to it.
+const word SYNTH_fineTune[16] PROGMEM = {
+	0, 237, 475, 714, 953, 1194, 1435, 1677, 1920, 2164, 2409, 2655, 2902, 3149, 3397, 3647
+};
+
+// Multiplying the sum of the sample values of N oscillators minus their 0-line
+// (N * 0x80) with the N-th entry of this table (256 / N) scales it to the full
+// signed 16-bit range. This is used in DAC16 output mode instead of dividing
+// the sum by N. Adding 0x8000 then gives the same 0-line for any N.
+const word SYNTH_mixerGain[SYNTH__MAX_OSCILLATORS + 1] PROGMEM = {
+	0, 256, 128, 85, 64
+};
 
 
 // Make an instance of "SynthClass" and name it "Synth".
@@ -192,12 +313,30 @@ SynthClass Synth;
  * pin 3 and 11 as all others by default can not output a 62.5 kHz PWM or are
  * already used by the default Arduino firmware.
  *
+ * If the other one of both pins gets passed as "secondPin" the synthesizer
+ * runs in dual output mode. Both pins are driven by TIMER2 so they get updated
+ * in the same ISR. By default the even oscillators get mixed to the first pin
+ * and the odd ones to the second pin. See "setVoiceOutput".
+ *
+ * Passing SYNTH__OUTPUT_DAC16 as "mode" uses both pins as a 16-bit D/A
+ * converter instead. The mixer then keeps the full resolution of all added
+ * oscillators instead of dividing it down to 8 bit. This requires an external
+ * resistor network and costs a 16-bit multiplication per sample.
+ *
  * @param uint8_t pin: The pin which to use for generating the audio signal
+ * @param uint8_t secondPin: The pin for the second channel or the high byte
+ * @param byte mode: Either SYNTH__OUTPUT_DUAL or SYNTH__OUTPUT_DAC16
  * @return void
  */
-void SynthClass::init(uint8_t pin) {
+void SynthClass::init(uint8_t pin, uint8_t secondPin, byte mode) {
 	byte i;
-	nextSampleValue = SYNTH__ANALOG_HALF;
+	nextSampleValue = SYNTH__ANALOG_HALF | ((word)SYNTH__ANALOG_HALF << 8);
+	outputMode = SYNTH__OUTPUT_MONO;
+	tempoScale = 100;
+	transpose = 0;
+	eventMask = 0;
+	clockMode = SYNTH__CLOCK_INTERNAL;
+	eventRead = eventWrite;
 	#ifdef __AVR_ATmega328P__
 	if (pin == 3 || pin == 11) {
 		// Works only on pin 3 or 11 as all other pins do not allow to
@@ -209,23 +348,134 @@ void SynthClass::init(uint8_t pin) {
 		// and "delayMicroseconds()" functions to only wait for 1/64 of
 		// the requested delay.
 		// So for now we stick to pins 3 and 11 and using TIMER2
-		pinMode(pin, OUTPUT);
 		TCCR2B = TCCR2B & 0b11111000 | 0x01;
-		switch (pin) {
-			case 3:
-				TCCR2A = TCCR2A & 0b11001100 | 0b00100011;
-				sampleRegister = (intptr_t)&OCR2B;
-			break;
-			case 11:
-				TCCR2A = TCCR2A & 0b00111100 | 0b10000011;
-				sampleRegister = (intptr_t)&OCR2A;
-			break;
-		}
+		sampleRegister = enablePin(pin);
 		*((byte*)sampleRegister) = nextSampleValue;
+		if ((secondPin == 3 || secondPin == 11) && secondPin != pin) {
+			outputMode = (mode == SYNTH__OUTPUT_DAC16) ? SYNTH__OUTPUT_DAC16 : SYNTH__OUTPUT_DUAL;
+			secondSampleRegister = enablePin(secondPin);
+			*((byte*)secondSampleRegister) = nextSampleValue >> 8;
+		}
 	}
 	#else
 		#error Not implemented for your processor type!
 	#endif
+	for (i = 0; i < SYNTH__MAX_OSCILLATORS; i++) {
+		if (outputMode == SYNTH__OUTPUT_DUAL && (i & 0x1)) {
+			voices[i].channels = SYNTH__CHANNEL_SECOND;
+		} else {
+			voices[i].channels = SYNTH__CHANNEL_FIRST;
+		}
+		voices[i].output = voices[i].channels;
+	}
+}
+
+/**
+ * Selects the waveform of an oscillator. Effects being played by the oscillator
+ * use the same waveform. This takes effect at the next tick.
+ *
+ * @param byte voice: The oscillator (track number)
+ * @param byte waveform: One of the SYNTH__WAVE_* values
+ * @return void
+ */
+void SynthClass::setWaveform(byte voice, byte waveform) {
+	if (voice >= SYNTH__MAX_OSCILLATORS || waveform > SYNTH__WAVE_SAWTOOTH) {
+		return;
+	}
+#if !SYNTH__WAVETABLES
+	waveform = SYNTH__WAVE_SINE;
+#endif
+	voices[voice].waveform = waveform;
+	voicesChanged = true;
+}
+
+/**
+ * Enables or disables linear interpolation between table values for an
+ * oscillator. This reduces the audible steps of low notes for which the
+ * table index advances by less than one step per sample. Interpolation
+ * only gets done while it fits into the cycle budget of the ISR. This takes
+ * effect at the next tick.
+ *
+ * @param byte voice: The oscillator (track number)
+ * @param bool enable: Whether to interpolate
+ * @return void
+ */
+void SynthClass::setInterpolation(byte voice, bool enable) {
+	if (voice >= SYNTH__MAX_OSCILLATORS) {
+		return;
+	}
+	voices[voice].interpolate = enable;
+	voicesChanged = true;
+}
+
+/**
+ * Defines to which output channels an oscillator gets mixed in dual output
+ * mode. An oscillator mixed to both channels is panned to the center. As every
+ * channel gets divided only by the number of oscillators mixed to it this
+ * gives every oscillator a higher amplitude resolution than in mono mode.
+ * This takes effect at the next tick.
+ *
+ * In mono output mode this method does nothing.
+ *
+ * @param byte voice: The oscillator (track number) to route
+ * @param byte channels: A combination of the SYNTH__CHANNEL_* bits
+ * @return void
+ */
+void SynthClass::setVoiceOutput(byte voice, byte channels) {
+	if (outputMode != SYNTH__OUTPUT_DUAL || voice >= SYNTH__MAX_OSCILLATORS) {
+		return;
+	}
+	voices[voice].output = channels & SYNTH__CHANNEL_BOTH;
+	voicesChanged = true;
+}
+
+/**
+ * Transposes all tracks by the given number of semitones. This takes effect
+ * at the next tick and stays active for all following songs. Notes which get
+ * transposed out of the MIDI note range are muted. Sound effects do not get
+ * transposed.
+ *
+ * @param int8_t semitones: The number of semitones (negative to transpose down)
+ * @return void
+ */
+void SynthClass::setTranspose(int8_t semitones) {
+	transpose = semitones;
+	voicesChanged = true;
+}
+
+/**
+ * Detunes an oscillator by the given number of 1/16 semitones. Playing the
+ * same notes on two oscillators with a slightly different tuning gives a
+ * chorus effect. This takes effect at the next tick.
+ *
+ * @param byte voice: The oscillator (track number)
+ * @param int8_t sixteenths: The tuning offset in 1/16 semitones
+ * @return void
+ */
+void SynthClass::setDetune(byte voice, int8_t sixteenths) {
+	if (voice >= SYNTH__MAX_OSCILLATORS) {
+		return;
+	}
+	voices[voice].detune = sixteenths;
+	voicesChanged = true;
+}
+
+/**
+ * Scales the tempo of the song being played and all following songs. A value
+ * of 100 plays songs at the speed given by "samplesPerTick", 200 plays them
+ * twice as fast and 50 at half the speed. The next tick gets the new length.
+ *
+ * @param word percent: The tempo in percent of the original tempo (10 - 1000)
+ * @return void
+ */
+void SynthClass::setTempoScale(word percent) {
+	if (percent < SYNTH__MIN_TEMPO_SCALE) {
+		percent = SYNTH__MIN_TEMPO_SCALE;
+	} else if (percent > SYNTH__MAX_TEMPO_SCALE) {
+		percent = SYNTH__MAX_TEMPO_SCALE;
+	}
+	tempoScale = percent;
+	updateTempo();
 }
 
 /**
@@ -233,12 +483,16 @@ void SynthClass::init(uint8_t pin) {
  *
  * @param SYNTH_TRACK *_tracks: A pointer to an array of track structures
  * @param byte _trackCount: The number of track structures being pointed to
+ * @param word _samplesPerTick: The length of a MIDI tick in samples
+ * @param SYNTH_CHECKPOINT *_checkpoints: An optional checkpoint index for the tracks
+ * @param word _checkpointCount: The number of checkpoints being pointed to
  * @return void
  */
-void SynthClass::play(const SYNTH_TRACK *_tracks, byte _trackCount, word _samplesPerTick) {
+void SynthClass::play(const SYNTH_TRACK *_tracks, byte _trackCount, word _samplesPerTick, const SYNTH_CHECKPOINT *_checkpoints, word _checkpointCount) {
+	SYNTH_RATE rate;
 	byte i;
 
-	if (trackCount > SYNTH__MAX_OSCILLATORS) {
+	if (_trackCount > SYNTH__MAX_OSCILLATORS) {
 		// A maxium of 4 simultaneous tracks (oscillators) is supported currently.
 		// We are having only a 8-bit PWM. When mixing 4 channels/oscillator every 
 		// channel must only swing at an amplitude of 256/4 = 64 = 6 bit. So in fact
@@ -252,20 +506,37 @@ void SynthClass::play(const SYNTH_TRACK *_tracks, byte _trackCount, word _sample
 	}
 	trackCount = _trackCount;
 	tracks = (SYNTH_TRACK*)_tracks;
-	samplesPerTick = _samplesPerTick;
+	songSamplesPerTick = _samplesPerTick;
+	checkpoints = (SYNTH_CHECKPOINT*)_checkpoints;
+	checkpointCount = _checkpointCount;
+	loopEnd = 0;
 
 	// Reset all oscillators and tracks
 	for (i = 0; i < SYNTH__MAX_OSCILLATORS; i++) {
-		noteIndex[i] = 0;
-		currentNote[i] = SYNTH__NOTE_PAUSE;		// Note 0x80 means pause;
-		currentDuration[i] = 0;
-		currentPeriodIndex[i] = 0;
-		currentPeriodFraction[i] = 0;
+		voices[i].phase = 0;
+		voices[i].phaseFraction = 0;
+	}
+	selectSampleRate(&rate, _trackCount, _samplesPerTick);
+	applyRate(&rate);
+	resetTracks();
+	tickTime = 0;
+	clockPhase = 0;
+	clockCredit = 0;
+	clockInterval = 0;
+	clockTickLength = 0;
+	clockStarted = false;
+	if (clockMode & SYNTH__CLOCK_OUTPUT) {
+		// The first clock byte marks the start of the song
+		clockPending = 1;
+		sendClock();
 	}
 	handleTick();
+	updateVoices();
 
 	sampleCounter = samplesPerTick;
-	pwmCounter = SYNTH__PWM_CYCLES_PER_SAMPLE;
+	tickLength = sampleCounter;
+	tickFraction = 0;
+	pwmCounter = pwmCyclesPerSample;
 
 	// enable timer 0 overflow interrupt
 #ifdef __AVR_ATmega328P__
@@ -275,19 +546,431 @@ void SynthClass::play(const SYNTH_TRACK *_tracks, byte _trackCount, word _sample
 #endif
 }
 
+/**
+ * Queues the passed tracks for being played after the current song has ended.
+ * The switch to the queued song happens within the tick in which the current
+ * song ends. So there is neither a gap nor a reset of the oscillators.
+ *
+ * If no song is playing currently the passed tracks get played immediately.
+ * The parameters are the same as for "play".
+ *
+ * @param SYNTH_TRACK *_tracks: A pointer to an array of track structures
+ * @param byte _trackCount: The number of track structures being pointed to
+ * @param word _samplesPerTick: The length of a MIDI tick in samples
+ * @param SYNTH_CHECKPOINT *_checkpoints: An optional checkpoint index for the tracks
+ * @param word _checkpointCount: The number of checkpoints being pointed to
+ * @return bool Returns FALSE if the queue is full or the song is invalid
+ */
+bool SynthClass::enqueue(const SYNTH_TRACK *_tracks, byte _trackCount, word _samplesPerTick, const SYNTH_CHECKPOINT *_checkpoints, word _checkpointCount) {
+	byte oldSREG;
+	byte next;
+	SYNTH_SONG *song;
+	SYNTH_RATE rate;
+
+	if (_trackCount == 0 || _trackCount > SYNTH__MAX_OSCILLATORS) {
+		return false;
+	}
+	// The ISR only copies the sampling frequency and tick length when
+	// it switches to the song.
+	selectSampleRate(&rate, _trackCount, _samplesPerTick);
+
+	oldSREG = SREG;
+	cli();
+	if (!trackCount) {
+		SREG = oldSREG;
+		play(_tracks, _trackCount, _samplesPerTick, _checkpoints, _checkpointCount);
+		return true;
+	}
+	next = (queueWrite + 1) % (SYNTH__QUEUE_LENGTH + 1);
+	if (next == queueRead) {
+		SREG = oldSREG;
+		return false;
+	}
+	song = queue + queueWrite;
+	song->tracks = (SYNTH_TRACK*)_tracks;
+	song->trackCount = _trackCount;
+	song->samplesPerTick = _samplesPerTick;
+	song->checkpoints = (SYNTH_CHECKPOINT*)_checkpoints;
+	song->checkpointCount = _checkpointCount;
+	song->rate = rate;
+	queueWrite = next;
+	SREG = oldSREG;
+	return true;
+}
+
+/**
+ * Returns the number of songs waiting in the queue
+ *
+ * @return byte The number of queued songs
+ */
+byte SynthClass::queued() {
+	return (queueWrite + SYNTH__QUEUE_LENGTH + 1 - queueRead) % (SYNTH__QUEUE_LENGTH + 1);
+}
+
+/**
+ * Plays a short sound effect (like a button beep) on top of the current song.
+ * The effect is a single track in the same format as the tracks of a song and
+ * its note durations are counted in the ticks of the song being played.
+ *
+ * The effect will start with the next tick. It uses an oscillator which is not
+ * used by the song. If all oscillators are in use the one of the last track
+ * gets taken over. So put the least important track last. The stolen track
+ * continues to advance silently and will be audible again as soon as the
+ * effect has ended. The mixer takes the additional oscillator into account
+ * so the output will not clip.
+ *
+ * If no song is playing the effect gets played like a song of one track.
+ *
+ * @param SYNTH_TRACK *effect: A pointer to the track structure of the effect
+ * @param word _samplesPerTick: The tick length used if no song is playing
+ * @return bool Returns FALSE if all effect slots are in use
+ */
+bool SynthClass::playEffect(const SYNTH_TRACK *effect, word _samplesPerTick) {
+	byte oldSREG;
+	byte e;
+	byte i;
+	byte j;
+	byte voice;
+	bool used;
+
+	oldSREG = SREG;
+	cli();
+	if (!trackCount) {
+		SREG = oldSREG;
+		play(effect, 1, _samplesPerTick);
+		return true;
+	}
+	for (e = 0; e < SYNTH__MAX_EFFECTS; e++) {
+		if (!effectState[e].note) {
+			break;
+		}
+	}
+	if (e == SYNTH__MAX_EFFECTS) {
+		SREG = oldSREG;
+		return false;
+	}
+
+	// Prefer the first oscillator not used by any track or effect. Else
+	// take over the last oscillator not yet used by another effect.
+	voice = SYNTH__MAX_OSCILLATORS;
+	for (i = 0; i < SYNTH__MAX_OSCILLATORS; i++) {
+		used = false;
+		for (j = 0; j < SYNTH__MAX_EFFECTS; j++) {
+			if (effectState[j].note && effectVoice[j] == i) {
+				used = true;
+			}
+		}
+		if (!used) {
+			if (i >= trackCount) {
+				voice = i;
+				break;
+			}
+			voice = i;
+		}
+	}
+
+	loadTrack(effectState + e, effect, 0);
+	effectVoice[e] = voice;
+	SREG = oldSREG;
+	return true;
+}
+
 /**
  * Stops playing any currently playing tracks by disabling
- * the TIMER0 overflow interrupts
+ * the TIMER0 overflow interrupts. Any queued songs and sound
+ * effects get dropped.
  *
  * @return void
  */
 void SynthClass::stop() {
+	byte e;
+
 	// disable timer 0 overflow interrupt
 #ifdef __AVR_ATmega328P__
 	cbi(TIMSK2, TOIE2);
 #endif
 	// We use "trackCount" to determine whether currently a song is playing
 	trackCount = 0;
+	queueRead = queueWrite;
+	for (e = 0; e < SYNTH__MAX_EFFECTS; e++) {
+		effectState[e].note = NULL;
+	}
+}
+
+/**
+ * Continues playing the current song at the specified tick. If the song has
+ * been started with a checkpoint index the nearest checkpoint before the tick
+ * gets found using a binary search and only the notes between this checkpoint
+ * and the requested tick have to get skipped. Without an index all notes from
+ * the beginning of the song have to get skipped.
+ *
+ * The oscillators are not reset so there will be no click when seeking.
+ *
+ * @param unsigned long tick: The tick at which to continue playing
+ * @return void
+ */
+void SynthClass::seek(unsigned long tick) {
+	SYNTH_TRACK_STATE state[SYNTH__MAX_OSCILLATORS];
+	SYNTH_TRACK *song;
+	byte oldSREG;
+	byte i;
+
+	oldSREG = SREG;
+	cli();
+	song = trackCount ? tracks : NULL;
+	SREG = oldSREG;
+	if (!song) {
+		return;
+	}
+	// Skipping the notes takes a while. So it is done with interrupts
+	// enabled and only the result gets copied into the tracks.
+	seekTick(state, tick);
+
+	oldSREG = SREG;
+	cli();
+	if (trackCount && tracks == song) {
+		// Otherwise the song has ended or the next one has started meanwhile
+		for (i = 0; i < trackCount; i++) {
+			trackState[i] = state[i];
+		}
+		currentTick = tick;
+		updateVoices();
+		restartTick();
+	}
+	SREG = oldSREG;
+}
+
+/**
+ * Defines a region of the current song which will get played in an endless
+ * loop. When the tick "endTick" is reached playing will continue at "startTick"
+ * without any gap. So a song can have an intro which gets played only once.
+ *
+ * The state of all tracks at "startTick" gets determined here like "seek"
+ * does and stored so the ISR only has to copy it when jumping back. So this
+ * takes as long as "seek". Passing an "endTick" of zero disables looping.
+ *
+ * @param unsigned long startTick: The first tick of the loop region
+ * @param unsigned long endTick: The tick at which to jump back to "startTick"
+ * @return void
+ */
+void SynthClass::setLoop(unsigned long startTick, unsigned long endTick) {
+	SYNTH_TRACK_STATE state[SYNTH__MAX_OSCILLATORS];
+	SYNTH_TRACK *song;
+	byte oldSREG;
+	byte i;
+
+	if (endTick && startTick >= endTick) {
+		return;
+	}
+	// The loop region stays disabled until its start state is complete
+	oldSREG = SREG;
+	cli();
+	loopEnd = 0;
+	song = trackCount ? tracks : NULL;
+	SREG = oldSREG;
+	if (!song || !endTick) {
+		loopStart = startTick;
+		return;
+	}
+	// Determine the state at the start of the loop region with interrupts
+	// enabled like "seek" does.
+	seekTick(state, startTick);
+
+	oldSREG = SREG;
+	cli();
+	if (trackCount && tracks == song) {
+		for (i = 0; i < trackCount; i++) {
+			loopState[i] = state[i];
+		}
+		loopStart = startTick;
+		loopEnd = endTick;
+		if (currentTick >= loopEnd) {
+			// The loop region has already been passed. Continue at its start.
+			for (i = 0; i < trackCount; i++) {
+				trackState[i] = state[i];
+			}
+			currentTick = loopStart;
+			updateVoices();
+			restartTick();
+		}
+	}
+	SREG = oldSREG;
+}
+
+/**
+ * Returns the time having elapsed since the song was started using "play" in
+ * PWM periods (1/62500 s). This is the time base of the events returned by
+ * "pollEvent". So it can get used to find out how long ago an event occured.
+ *
+ * @return unsigned long The current time
+ */
+unsigned long SynthClass::getTime() {
+	unsigned long time;
+	byte oldSREG;
+
+	oldSREG = SREG;
+	cli();
+	time = tickTime + (unsigned long)(tickLength - sampleCounter) * pwmCyclesPerSample;
+	SREG = oldSREG;
+	return time;
+}
+
+/**
+ * Selects the types of events which get reported by "pollEvent". No events
+ * get reported by default. Events cost no CPU time when they are disabled.
+ *
+ * @param byte mask: A combination of the SYNTH__EVENT_* types
+ * @return void
+ */
+void SynthClass::setEvents(byte mask) {
+	eventMask = mask;
+}
+
+/**
+ * Fetches the oldest event from the event queue. Call this from "loop" to
+ * synchronize lights, motors or displays with the music. The events get
+ * queued by the ISR and no code of the sketch ever gets called from it.
+ * The queue holds SYNTH__EVENT_QUEUE_LENGTH - 1 events. Events occuring while
+ * the queue is full get dropped.
+ *
+ * @param SYNTH_EVENT *event: Receives the event
+ * @return bool Returns FALSE if there is no event
+ */
+bool SynthClass::pollEvent(SYNTH_EVENT *event) {
+	byte read = eventRead;
+
+	if (read == eventWrite) {
+		return false;
+	}
+	// The event must not get read before "eventWrite" showed it is there
+	SYNTH__MEMORY_BARRIER();
+	*event = events[read];
+	SYNTH__MEMORY_BARRIER();
+	eventRead = (read + 1) & (SYNTH__EVENT_QUEUE_LENGTH - 1);
+	return true;
+}
+
+/**
+ * Selects whether the tick rate is sent as or follows a MIDI clock. This
+ * allows several boards playing parts of one arrangement to stay in sync.
+ *
+ * With SYNTH__CLOCK_OUTPUT a MIDI clock byte (0xF8) gets sent 24 times per
+ * quarter note. The UART gets set up for the MIDI baud rate. It must not get
+ * used for sending other data then. The clock bytes get written from the ISR
+ * only when the UART is ready so sending never blocks.
+ *
+ * With SYNTH__CLOCK_FOLLOW the ticks of a song only advance when clock bytes
+ * get passed to "midiClock". Read them from the UART (e.g. using "Serial") in the
+ * "loop" of the sketch. Call "play" when the song is started on the board
+ * sending the clock. Both modes may get combined to pass the clock on.
+ *
+ * The converter "midi.php" writes "ticksPerQuarterNote" into the sketch.
+ *
+ * @param byte mode: A combination of the SYNTH__CLOCK_* flags
+ * @param word _ticksPerQuarterNote: The ticks per quarter note of the songs
+ * @return void
+ */
+void SynthClass::setClock(byte mode, word _ticksPerQuarterNote) {
+	byte oldSREG;
+
+	oldSREG = SREG;
+	cli();
+	#ifdef __AVR_ATmega328P__
+	if (mode & SYNTH__CLOCK_OUTPUT) {
+		// 8 data bits, no parity, one stop bit
+		UBRR0H = (F_CPU / 16 / SYNTH__MIDI_BAUD_RATE - 1) >> 8;
+		UBRR0L = (F_CPU / 16 / SYNTH__MIDI_BAUD_RATE - 1) & 0xFF;
+		UCSR0A = 0;
+		UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+		UCSR0B |= _BV(TXEN0);
+	}
+	#endif
+	clockMode = mode;
+	ticksPerQuarterNote = _ticksPerQuarterNote ? _ticksPerQuarterNote : SYNTH__CLOCKS_PER_QUARTER_NOTE;
+	clockPhase = 0;
+	clockPending = 0;
+	clockCredit = 0;
+	clockInterval = 0;
+	clockTickLength = 0;
+	clockStarted = false;
+	SREG = oldSREG;
+}
+
+/**
+ * Passes a byte received from a MIDI input to the synthesizer. Clock bytes
+ * allow the song to advance by the ticks of 1/24 quarter note when following
+ * an external clock. All other bytes are ignored. The ticks up to the one of
+ * the next clock byte get played in advance. That one has to wait for the
+ * clock byte so the song never runs ahead of the external clock.
+ *
+ * The tick length gets calculated from the average interval between the
+ * clock bytes. So the delay between receiving a byte and calling this method
+ * only has to be about the same for every byte. A pause in the clock of more
+ * than four times the average interval does not change the tick length.
+ *
+ * @param byte data: The byte received
+ * @return void
+ */
+void SynthClass::midiClock(byte data) {
+	unsigned long now;
+	unsigned long interval;
+	unsigned long length = 0;
+	word credit = ticksPerQuarterNote;
+	byte oldSREG;
+
+	if (data != SYNTH__MIDI_CLOCK || !(clockMode & SYNTH__CLOCK_FOLLOW) || !trackCount) {
+		return;
+	}
+	now = getTime();
+	interval = now - lastClockTime;
+	lastClockTime = now;
+	if (clockStarted) {
+		if (!clockInterval) {
+			clockInterval = interval << SYNTH__CLOCK_SMOOTHING;
+		} else if (interval < (clockInterval >> (SYNTH__CLOCK_SMOOTHING - 2))) {
+			clockInterval += interval - (clockInterval >> SYNTH__CLOCK_SMOOTHING);
+		}
+		// The tick length in PWM periods with an 8-bit fraction
+		length = clockInterval * SYNTH__CLOCKS_PER_QUARTER_NOTE / ticksPerQuarterNote;
+		length <<= 8 - SYNTH__CLOCK_SMOOTHING;
+		// Play about 3% faster than the clock. So the ticks reach the
+		// tick of the next clock byte slightly early and wait for it
+		// instead of lagging behind.
+		length -= length >> 5;
+	} else {
+		// The first clock byte has been sent in the first tick which
+		// has already been played by "play".
+		credit = (credit > SYNTH__CLOCKS_PER_QUARTER_NOTE) ? credit - SYNTH__CLOCKS_PER_QUARTER_NOTE : 0;
+	}
+	clockStarted = true;
+
+	oldSREG = SREG;
+	cli();
+	if (clockCredit <= 0xFFFF - credit) {
+		clockCredit += credit;
+	}
+	SREG = oldSREG;
+	if (length) {
+		// The divisions of "updateTempo" run with interrupts enabled
+		clockTickLength = length;
+		updateTempo();
+	}
+}
+
+/**
+ * Returns the number of ticks having elapsed since the song was started
+ *
+ * @return unsigned long The current tick
+ */
+unsigned long SynthClass::getTick() {
+	unsigned long tick;
+	byte oldSREG;
+
+	oldSREG = SREG;
+	cli();
+	tick = currentTick;
+	SREG = oldSREG;
+	return tick;
 }
 
 /**
@@ -299,6 +982,93 @@ bool SynthClass::isPlaying() {
 	return trackCount ? true : false;
 }
 
+/**
+ * Can get used to determine whether currently all oscillators are silent.
+ * This is the case during rests of a song or when no song is playing.
+ *
+ * @return bool Returns TRUE if no note is sounding currently.
+ */
+bool SynthClass::isSilent() {
+	return (!trackCount || !activeCount) ? true : false;
+}
+
+/**
+ * Returns the number of oscillators sounding currently. Tracks being in a
+ * pause and tracks having ended are not counted.
+ *
+ * @return byte The number of sounding oscillators
+ */
+byte SynthClass::getVoiceCount() {
+	return trackCount ? activeCount : 0;
+}
+
+/**
+ * Returns the sampling frequency selected for the current song. It depends
+ * on the number of tracks of the song (see "selectSampleRate").
+ *
+ * @return word The number of samples per second
+ */
+word SynthClass::getSampleRate() {
+	if (!pwmCyclesPerSample) {
+		return SYNTH__SAMPLES_PER_SECOND;
+	}
+	return SYNTH__PWM_FREQUENCY / pwmCyclesPerSample;
+}
+
+/**
+ * Returns the estimated CPU cycles the ISRs take during one sample period
+ * with the oscillators sounding currently. The SYNTH__CYCLES_* values get
+ * added up the same way as for selecting the sampling frequency and for
+ * enabling interpolation (see "calculateTickLength"). A sample period has
+ * "256 * SYNTH__PWM_FREQUENCY / getSampleRate()" cycles.
+ *
+ * @return word The estimated cycles or 0 if no song is playing
+ */
+word SynthClass::getCycles() {
+	word cycles;
+	word length;
+	byte i;
+	byte oldSREG;
+
+	oldSREG = SREG;
+	cli();
+	if (!trackCount) {
+		SREG = oldSREG;
+		return 0;
+	}
+	if (activeCount) {
+		cycles = SYNTH__CYCLES_PER_SAMPLE;
+		for (i = 0; i < activeCount; i++) {
+			cycles += SYNTH__CYCLES_PER_VOICE;
+			if (interpolate && activeVoices[i]->interpolate) {
+				cycles += SYNTH__CYCLES_PER_INTERPOLATION;
+			}
+		}
+	} else {
+		// During a rest only the samples and ticks get counted
+		cycles = SYNTH__CYCLES_PER_ISR;
+	}
+	cycles += (pwmCyclesPerSample - 1) * SYNTH__CYCLES_PER_ISR;
+	length = samplesPerTick;
+	SREG = oldSREG;
+	return cycles + SYNTH__CYCLES_PER_TICK / length;
+}
+
+/**
+ * Puts the CPU to sleep until the next interrupt occurs. Call this from the
+ * main loop whenever there is nothing else to do. The idle sleep mode keeps
+ * the timers running so the synthesizer continues to play. During rests the
+ * ISR only has to count the samples and ticks so the CPU sleeps most of the
+ * time. The PWM must keep running to output the 0-line so the interrupts
+ * can not get disabled completely.
+ *
+ * @return void
+ */
+void SynthClass::sleep() {
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_mode();
+}
+
 
 /*************************************************************************
  **
@@ -341,6 +1111,110 @@ inline byte SynthClass::getSineValue(word index) {
    return result;
 }
 
+/**
+ * Enables the PWM output of TIMER2 for the passed pin.
+ *
+ * @param uint8_t pin: Either pin 3 or 11
+ * @return intptr_t The address of the output compare register of the pin
+ */
+intptr_t SynthClass::enablePin(uint8_t pin) {
+	pinMode(pin, OUTPUT);
+	switch (pin) {
+		case 3:
+			TCCR2A = TCCR2A & 0b11001100 | 0b00100011;
+			return (intptr_t)&OCR2B;
+		break;
+		default:
+			TCCR2A = TCCR2A & 0b00111100 | 0b10000011;
+			return (intptr_t)&OCR2A;
+		break;
+	}
+}
+
+/**
+ * This method calculates the value between two table entries for the current
+ * period index and fraction of an oscillator. The difference between both
+ * entries gets multiplied by the fraction using the hardware multiplier.
+ *
+ * For the wave tables, which have fewer entries than the 1024 steps of the
+ * period index, the lowest bits of the period index become the highest bits
+ * of the fraction.
+ *
+ * @param SYNTH_VOICE *voice: The oscillator for which to calculate the value
+ * @return byte: The interpolated value
+ */
+inline byte SynthClass::getInterpolatedValue(SYNTH_VOICE *voice) {
+	word index = voice->phase;
+	byte fraction = voice->phaseFraction;
+	byte first;
+	byte second;
+
+#if SYNTH__WAVETABLES
+	const byte *table = voice->table;
+	if (table) {
+		fraction = (index << (8 - SYNTH__WAVE_TABLE_SHIFT)) | (fraction >> SYNTH__WAVE_TABLE_SHIFT);
+		index = (index >> SYNTH__WAVE_TABLE_SHIFT) & SYNTH__WAVE_TABLE_MASK;
+		first = pgm_read_byte(table + index);
+		second = pgm_read_byte(table + ((index + 1) & SYNTH__WAVE_TABLE_MASK));
+	} else
+#endif
+	{
+		first = getSineValue(index);
+		second = getSineValue(index + 1);
+	}
+	// The product of the difference and the fraction needs all 16 bits. So
+	// it has to get calculated unsigned. The result gets rounded as the
+	// sine entries differ by at most one.
+	if (second >= first) {
+		return first + (((word)(second - first) * fraction + 0x80) >> 8);
+	}
+	return first - (((word)(first - second) * fraction + 0x80) >> 8);
+}
+
+/**
+ * Advances the phase of an oscillator by one sample using the increment of
+ * the current note which has been looked up when the note got loaded.
+ *
+ * @param SYNTH_VOICE *voice: The oscillator to advance
+ * @return void
+ */
+inline void SynthClass::advancePhase(SYNTH_VOICE *voice) {
+	voice->phase += voice->increment;
+	voice->phaseFraction += voice->incrementFraction;
+
+	// When fraction overflows increment the index
+	if (voice->phaseFraction < voice->incrementFraction) {
+		voice->phase++;
+	}
+	// We do not need to check for "index" overflowing 0x3FF. If this
+	// is the case we simply ignore it as it gets truncated in "getSineValue"
+	// anyways.
+}
+
+/**
+ * Retrieves the current value of an oscillator from its wave table or the
+ * sine table and advances its phase. This is the innermost part of the
+ * sample loop and gets done for every sounding oscillator.
+ *
+ * @param SYNTH_VOICE *voice: The oscillator to calculate
+ * @return byte: The sample value of the oscillator
+ */
+inline byte SynthClass::stepOscillator(SYNTH_VOICE *voice) {
+	byte sample;
+
+#if SYNTH__WAVETABLES
+	if (voice->table) {
+		// The wave tables contain a whole period
+		sample = pgm_read_byte(voice->table + ((voice->phase >> SYNTH__WAVE_TABLE_SHIFT) & SYNTH__WAVE_TABLE_MASK));
+	} else
+#endif
+	{
+		sample = getSineValue(voice->phase);
+	}
+	advancePhase(voice);
+	return sample;
+}
+
 /**
  * This method handles a MIDI "tick". It advances (decrements) the duration counter
  * of each osciallator. If the duration counter of an oscillator reaches zero it
@@ -356,147 +1230,758 @@ inline byte SynthClass::getSineValue(word index) {
  */
 void SynthClass::handleTick() {
 	byte i;
-	word tmp;
+	byte type;
 	byte finishedTracks = 0;
 	bool trackStart;
+	SYNTH_TRACK_STATE *track = trackState;
 
-	// These program-memory variables get loaded into data memory
-	word noteCount;
-	PGM_P notes;
-	PGM_P timeOffsets;
-	
-	for (i = 0; i < trackCount; i++) {
+	for (i = 0; i < trackCount; i++, track++) {
 		trackStart = false;
-		// We can just read the noteCount from program memory as it's address
-		// can get evaluated by the compiler
-		noteCount = pgm_read_word( &(tracks[i].noteCount) );
-		// For notes and timeOffsets read the address pointer first
-		notes = (PGM_P) pgm_read_word( &(tracks[i].notes) );
-		timeOffsets = (PGM_P) pgm_read_word( &((*(tracks+i)).timeOffsets) );
-		
-		if (noteIndex[i] >= noteCount) {
+		if (track->note >= track->noteEnd) {
 			// No more notes in this track.
-			currentNote[i] = SYNTH__NOTE_PAUSE;
-			currentDuration[i] = 0;
+			if (track->currentNote != SYNTH__NOTE_PAUSE) {
+				voicesChanged = true;
+			}
+			track->currentNote = SYNTH__NOTE_PAUSE;
+			track->duration = 0;
 			finishedTracks++;
 		} else {
-			if (currentDuration[i] == 0) {
+			if (track->duration == 0) {
 				// When duration is already 0 at this place it is the special case that
 				// the synth has just been started.
 				trackStart = true;
 			}
-			if (currentDuration[i]) {
+			if (track->duration) {
 				// A note is playing. Just decrement its duration.
-				currentDuration[i]--;
+				track->duration--;
 			}
 			do {
-				if (!currentDuration[i]) {
+				if (!track->duration) {
 					// A note has ended. First play the note which is actually pointed to as
 					// its event-time has now been reached. But take care if this is gets
 					// called for the first time in a track. Then we should play pause (0x80)
 					// as no note event may have been reached yet.
 					if (trackStart) {
-						currentNote[i] = SYNTH__NOTE_PAUSE;
-						currentDuration[i] = 0;
+						track->currentNote = SYNTH__NOTE_PAUSE;
+						track->duration = 0;
 						trackStart = false;
-						// Intentionally do NOT advance the note index here so the note index
-						// still points to the first note. Usually the note index should get
+						// Intentionally do NOT advance the note pointer here so it still
+						// points to the first note. Usually the note pointer should get
 						// advanced after having loaded the currently playing note. But using
-						// this mechanism we simulate that the noteIndex pointed to "-1" when
-						// the track/song got started (without using a signed number).
+						// this mechanism we simulate that the note pointer pointed to "-1"
+						// when the track/song got started.
 					} else {
-						// This works for reading the note. But why? In fact the macro would have
-						// To retrieve the ".notes" pointer first, then add the noteIndex offset
-						// and then retrieve the note.
-						// currentNote[i] = pgm_read_byte(tracks[i].notes + noteIndex[i]);
-						currentNote[i] = pgm_read_byte( notes + noteIndex[i] );
-
-						// Advance the note index of this track.
-						noteIndex[i]++;
+						// Load the note and advance both pointers of this track.
+						type = loadEvent(track);
+						if (type & eventMask) {
+							reportEvent(type, i, pgm_read_byte( track->note - 1 ));
+						}
 					}
 
-					// The noteIndex now points to the next note and its event-time. Load the
-					// event time for the next note into the currentDuration variable so the
-					// duration until that event can get counted down.
-					tmp = noteIndex[i] << 1;
-					currentDuration[i] = pgm_read_word( timeOffsets + tmp );
+					if (track->note >= track->noteEnd) {
+						// The last note has been loaded. There is no event time
+						// after it. The track will get finished with the next tick.
+						track->duration = 0;
+						break;
+					}
+					// The note pointer now points to the next note and the time offset
+					// pointer to its event-time. Load the event time for the next note
+					// into the duration variable so the duration until that event can
+					// get counted down.
+					track->duration = pgm_read_word( track->timeOffset );
 				}
 			// Load next event as long as the current event has a zero event-time offset.
-			} while (currentDuration[i] == 0);
+			} while (track->duration == 0);
 		}
 	}
 	if (finishedTracks >= trackCount) {
-		// Song has ended.
-		stop();
+		reportEvent(SYNTH__EVENT_SONG_END, 0, 0);
+		if (queueRead != queueWrite) {
+			// Song has ended but another one is waiting in the queue.
+			// Continue with it in this very tick.
+			nextSong();
+		} else {
+			// Song has ended.
+			stop();
+		}
 	}
 }
 
+/**
+ * This method handles a MIDI "tick" for the sound effects. It works the same
+ * way as "handleTick" does for the tracks. When an effect has played its last
+ * note its slot gets freed and its oscillator is given back to the track.
+ *
+ * Afterwards the notes for all oscillators get updated if a track or effect
+ * has loaded an event, an effect has started or ended or a setting of an
+ * oscillator has changed.
+ *
+ * @return void;
+ */
+void SynthClass::handleEffects() {
+	byte e;
+	bool trackStart;
+	SYNTH_TRACK_STATE *effect = effectState;
+
+	for (e = 0; e < SYNTH__MAX_EFFECTS; e++, effect++) {
+		if (!effect->note) {
+			continue;
+		}
+		if (effect->note >= effect->noteEnd) {
+			// The effect has ended
+			effect->note = NULL;
+			voicesChanged = true;
+			continue;
+		}
+		trackStart = (effect->duration == 0);
+		if (effect->duration) {
+			effect->duration--;
+		}
+		while (!effect->duration) {
+			if (trackStart) {
+				effect->currentNote = SYNTH__NOTE_PAUSE;
+				trackStart = false;
+			} else {
+				loadEvent(effect);
+			}
+			if (effect->note >= effect->noteEnd) {
+				// The last note has been loaded. The effect will end with the next tick.
+				break;
+			}
+			effect->duration = pgm_read_word( effect->timeOffset );
+		}
+	}
+	if (voicesChanged) {
+		updateVoices();
+	}
+}
 
 /**
- * This method determines the next analog sample value which has to get written
- * to the PWM (or external D/A). It does so by getting the current sine/pause
- * value for each configured track, adding them together and then dividing the
- * final result through the total number of tracks. This achieves a digital
- * signal mixing.
+ * Determines the note being played by each oscillator and the number of
+ * oscillators which have to get mixed. This has to get called whenever the
+ * notes of the tracks or effects have changed. Everything changing the
+ * result sets "voicesChanged" so the ISR only calls this when necessary.
  *
- * @return byte The next analog sample value
+ * @return void;
  */
-byte SynthClass::calculateNextSampleValue() {
+void SynthClass::updateVoices() {
 	byte i;
+	byte e;
+	word cycles;
+	byte note[SYNTH__MAX_OSCILLATORS];
+	int8_t bend[SYNTH__MAX_OSCILLATORS];
+	SYNTH_VOICE *voice;
+
+	voicesChanged = false;
+	voiceCount = trackCount;
+	for (i = 0; i < SYNTH__MAX_OSCILLATORS; i++) {
+		note[i] = SYNTH__NOTE_PAUSE;
+		bend[i] = 0;
+		if (i < trackCount && !(trackState[i].currentNote & SYNTH__NOTE_PAUSE)) {
+			// A note transposed below 0 or above 127 wraps to a value
+			// above 0x7F and so gets played as pause.
+			note[i] = trackState[i].currentNote + transpose;
+			bend[i] = trackState[i].bend;
+		}
+	}
+	for (e = 0; e < SYNTH__MAX_EFFECTS; e++) {
+		if (effectState[e].note) {
+			note[effectVoice[e]] = effectState[e].currentNote;
+			bend[effectVoice[e]] = effectState[e].bend;
+			if (effectVoice[e] >= voiceCount) {
+				voiceCount = effectVoice[e] + 1;
+			}
+		}
+	}
+
+	channelVoices[0] = 0;
+	channelVoices[1] = 0;
+	silentValue[0] = 0;
+	silentValue[1] = 0;
+	activeCount = 0;
+	cycles = SYNTH__CYCLES_PER_SAMPLE;
+	for (i = 0, voice = voices; i < voiceCount; i++, voice++) {
+		// The routing only changes here together with the channel counts
+		voice->channels = voice->output;
+		if (voice->channels & SYNTH__CHANNEL_FIRST) {
+			channelVoices[0]++;
+		}
+		if (voice->channels & SYNTH__CHANNEL_SECOND) {
+			channelVoices[1]++;
+		}
+		if (!loadVoice(voice, note[i], bend[i])) {
+			// A silent oscillator only adds the 0-line value
+			if (voice->channels & SYNTH__CHANNEL_FIRST) {
+				silentValue[0] += SYNTH__ANALOG_HALF;
+			}
+			if (voice->channels & SYNTH__CHANNEL_SECOND) {
+				silentValue[1] += SYNTH__ANALOG_HALF;
+			}
+			continue;
+		}
+		activeVoices[activeCount++] = voice;
+		cycles += SYNTH__CYCLES_PER_VOICE;
+		if (voice->interpolate) {
+			cycles += SYNTH__CYCLES_PER_INTERPOLATION;
+		}
+	}
+	mixerGain = pgm_read_word(&SYNTH_mixerGain[channelVoices[0]]);
+	interpolate = (cycles <= cycleLimit);
+	if (!activeCount) {
+		// Nothing is sounding. The output stays constant until
+		// a note gets loaded again.
+		idleSampleValue = calculateNextSampleValue();
+	}
+}
+
+/**
+ * Loads a note into an oscillator. The increment of the phase per sample gets
+ * looked up for the selected sampling frequency so the ISR does not have to
+ * read it from program memory for every sample.
+ *
+ * The pitch bend of the track and the fine tuning of the oscillator are added
+ * up in 1/16 semitones. Whole semitones select another note and the remaining
+ * fraction gets applied to the increment using the "SYNTH_fineTune" table.
+ *
+ * Also selects the wave table for the note. The phase increment of a note is
+ * the number of steps in a 1024 step period per sample. So a harmonic "h" of
+ * the note stays below half the sampling frequency as long as "h * increment"
+ * is below 512. The table of level "N" contains at most 128 >> N harmonics so
+ * the level is the number of bits of the increment above the lowest two. This
+ * does not depend on the sampling frequency.
+ *
+ * A note whose fundamental is already above half the sampling frequency gets
+ * muted.
+ *
+ * @param SYNTH_VOICE *voice: The oscillator which plays the note
+ * @param byte note: The note to play. A pause silences the oscillator.
+ * @param int8_t bend: The pitch bend of the track in 1/16 semitones
+ * @return bool Returns FALSE if the oscillator is silent
+ */
+bool SynthClass::loadVoice(SYNTH_VOICE *voice, byte note, int8_t bend) {
+	int offset;
+	int index;
+	byte fine;
 	word base;
 	byte fraction;
-	byte note;
+	unsigned long increment;
+	byte level;
 
-	word value = 0;
+	voice->table = NULL;
+	if (note & SYNTH__NOTE_PAUSE) {
+		return false;
+	}
+	// An arithmetic shift rounds down also for negative offsets. So the
+	// fine part is always positive.
+	offset = bend + voice->detune;
+	index = note + (offset >> 4);
+	fine = offset & 0x0F;
+	if (index < 0 || index > 0x7F) {
+		return false;
+	}
+	base = pgm_read_word(&periodBase[index]);
+	fraction = pgm_read_byte(&periodFraction[index]);
+	if (fine) {
+		increment = ((unsigned long)base << 8) | fraction;
+		increment += (increment * pgm_read_word(&SYNTH_fineTune[fine])) >> 16;
+		base = increment >> 8;
+		fraction = increment & 0xFF;
+	}
+	if (base >= 0x200) {
+		return false;
+	}
+	voice->increment = base;
+	voice->incrementFraction = fraction;
+#if SYNTH__WAVETABLES
+	if (voice->waveform != SYNTH__WAVE_SINE) {
+		level = 0;
+		base >>= 2;
+		while (base && level < SYNTH__WAVE_LEVELS - 1) {
+			level++;
+			base >>= 1;
+		}
+		voice->table = SYNTH_waveTables[voice->waveform - 1][level];
+	}
+#endif
+	return true;
+}
+
+/**
+ * Selects the highest sampling frequency at which the oscillators of a song
+ * still fit into the cycle budget. So a song with fewer tracks gets played
+ * with a higher fidelity instead of leaving the CPU idle. The oscillators
+ * which may get used by sound effects are taken into account. Interpolation
+ * is not: It only gets enabled by "updateVoices" if it fits into the time
+ * left at the selected sampling frequency.
+ *
+ * This does several 32-bit divisions. So it gets called by "play" and
+ * "enqueue" and the ISR only copies the result using "applyRate".
+ *
+ * @param SYNTH_RATE *rate: Receives the sampling frequency and tick length
+ * @param byte _trackCount: The number of tracks of the song
+ * @param word _samplesPerTick: The tick length passed to "play"
+ * @return void
+ */
+void SynthClass::selectSampleRate(SYNTH_RATE *rate, byte _trackCount, word _samplesPerTick) {
+	byte oscillators = _trackCount + SYNTH__MAX_EFFECTS;
+
+	if (oscillators > SYNTH__MAX_OSCILLATORS) {
+		oscillators = SYNTH__MAX_OSCILLATORS;
+	}
+	for (rate->pwmCyclesPerSample = SYNTH__MIN_PWM_CYCLES_PER_SAMPLE; ; rate->pwmCyclesPerSample++) {
+		calculateTickLength(rate, _samplesPerTick);
+		if (rate->pwmCyclesPerSample == SYNTH__PWM_CYCLES_PER_SAMPLE || SYNTH__CYCLES_PER_SAMPLE + oscillators * SYNTH__CYCLES_PER_VOICE <= rate->cycleLimit) {
+			break;
+		}
+	}
+}
+
+/**
+ * Calculates the length of a tick in samples at the sampling frequency of
+ * the passed rate from the "samplesPerTick" value passed to "play" and the
+ * tempo scale. The length gets stored as fixed point value with 8 fractional
+ * bits so the tempo does not depend on the sampling frequency. The ISR only
+ * reloads the sample counter with it at every tick.
+ *
+ * While following an external clock the tick length of the clock gets used
+ * instead. The tempo scale has no effect then.
+ *
+ * The number of cycles calculating a sample may take at this sampling
+ * frequency and tempo gets calculated as well. The ISR which calculates a
+ * sample must fit into SYNTH__CYCLES_BUDGET and all ISRs of one sample period
+ * together must not use more than SYNTH__MAX_CPU_LOAD percent of the CPU. The
+ * handling of a tick (SYNTH__CYCLES_PER_TICK) gets spread over the samples of
+ * the tick.
+ *
+ * @param SYNTH_RATE *rate: The rate with the PWM cycles per sample set
+ * @param word _samplesPerTick: The tick length passed to "play"
+ * @return void
+ */
+void SynthClass::calculateTickLength(SYNTH_RATE *rate, word _samplesPerTick) {
+	unsigned long numerator;
+	unsigned long denominator;
+	unsigned long length;
+	byte fraction;
+	long limit;
+
+	if ((clockMode & SYNTH__CLOCK_FOLLOW) && clockTickLength) {
+		length = clockTickLength / rate->pwmCyclesPerSample;
+		fraction = length & 0xFF;
+		length >>= 8;
+	} else {
+		// The tick length is "samplesPerTick * 5 / pwmCyclesPerSample * 100 / tempoScale".
+		// Its fraction gets calculated from the remainder so no intermediate value
+		// exceeds 32 bit.
+		numerator = (unsigned long)_samplesPerTick * SYNTH__PWM_CYCLES_PER_SAMPLE * 100;
+		denominator = (unsigned long)rate->pwmCyclesPerSample * tempoScale;
+		length = numerator / denominator;
+		fraction = ((numerator % denominator) << 8) / denominator;
+	}
+	if (length > 0xFFFF) {
+		rate->samplesPerTick = 0xFFFF;
+		rate->samplesPerTickFraction = 0xFF;
+	} else if (length == 0) {
+		rate->samplesPerTick = 1;
+		rate->samplesPerTickFraction = 0;
+	} else {
+		rate->samplesPerTick = length;
+		rate->samplesPerTickFraction = fraction;
+	}
+
+	limit = (long)rate->pwmCyclesPerSample * 256 * SYNTH__MAX_CPU_LOAD / 100;
+	limit -= (rate->pwmCyclesPerSample - 1) * SYNTH__CYCLES_PER_ISR;
+	limit -= SYNTH__CYCLES_PER_TICK / rate->samplesPerTick;
+	if (limit > SYNTH__CYCLES_BUDGET) {
+		limit = SYNTH__CYCLES_BUDGET;
+	} else if (limit < 0) {
+		limit = 0;
+	}
+	rate->cycleLimit = limit;
+}
+
+/**
+ * Switches to a sampling frequency and tick length calculated before. This
+ * only copies values so it can get called from the ISR.
+ *
+ * @param SYNTH_RATE *rate: The rate calculated by "selectSampleRate"
+ * @return void
+ */
+void SynthClass::applyRate(const SYNTH_RATE *rate) {
+	pwmCyclesPerSample = rate->pwmCyclesPerSample;
+	samplesPerTick = rate->samplesPerTick;
+	samplesPerTickFraction = rate->samplesPerTickFraction;
+	cycleLimit = rate->cycleLimit;
+	periodBase = SYNTH_periodBase[SYNTH__PWM_CYCLES_PER_SAMPLE - pwmCyclesPerSample];
+	periodFraction = SYNTH_periodFraction[SYNTH__PWM_CYCLES_PER_SAMPLE - pwmCyclesPerSample];
+}
+
+/**
+ * Recalculates the tick length of the current song and of the queued songs
+ * after the tempo scale or the tick length of an external clock has changed.
+ * The calculation is done with interrupts enabled. Only the results get
+ * stored with interrupts disabled.
+ *
+ * The queued songs get updated first. So if the ISR switches to the next
+ * song meanwhile the new tick length either is already part of the queue or
+ * gets calculated for the new current song below.
+ *
+ * @return void
+ */
+void SynthClass::updateTempo() {
+	SYNTH_RATE rate;
+	SYNTH_SONG *song;
+	word _samplesPerTick;
+	byte oldSREG;
+	byte i;
+
+	for (i = queueRead; i != queueWrite; i = (i + 1) % (SYNTH__QUEUE_LENGTH + 1)) {
+		song = queue + i;
+		rate.pwmCyclesPerSample = song->rate.pwmCyclesPerSample;
+		calculateTickLength(&rate, song->samplesPerTick);
+		oldSREG = SREG;
+		cli();
+		song->rate = rate;
+		SREG = oldSREG;
+	}
+
+	oldSREG = SREG;
+	cli();
+	if (!trackCount) {
+		SREG = oldSREG;
+		return;
+	}
+	rate.pwmCyclesPerSample = pwmCyclesPerSample;
+	_samplesPerTick = songSamplesPerTick;
+	SREG = oldSREG;
+
+	calculateTickLength(&rate, _samplesPerTick);
+
+	oldSREG = SREG;
+	cli();
+	if (rate.pwmCyclesPerSample == pwmCyclesPerSample && _samplesPerTick == songSamplesPerTick) {
+		// Otherwise the ISR has started a queued song which has been
+		// updated above already.
+		applyRate(&rate);
+	}
+	SREG = oldSREG;
+}
+
+/**
+ * Replaces the current song by the next one from the queue. This gets called
+ * from "handleTick" in the tick in which the current song has ended. The
+ * oscillators are not reset so the new song continues without a click.
+ *
+ * @return void
+ */
+void SynthClass::nextSong() {
+	SYNTH_SONG *song = queue + queueRead;
+	byte cyclesPerSample = pwmCyclesPerSample;
+
+	tracks = song->tracks;
+	trackCount = song->trackCount;
+	songSamplesPerTick = song->samplesPerTick;
+	checkpoints = song->checkpoints;
+	checkpointCount = song->checkpointCount;
+	loopEnd = 0;
+	queueRead = (queueRead + 1) % (SYNTH__QUEUE_LENGTH + 1);
+
+	applyRate(&song->rate);
+	if (pwmCyclesPerSample != cyclesPerSample) {
+		// Start counting the samples at the new rate right away. The
+		// increments of all oscillators including the ones of sound
+		// effects get reloaded from the new tables by "updateVoices".
+		pwmCounter = pwmCyclesPerSample;
+		voicesChanged = true;
+	}
+	sampleCounter = samplesPerTick;
+	tickLength = sampleCounter;
+	if (clockMode & SYNTH__CLOCK_OUTPUT) {
+		// The clock bytes of the next song start with its first tick
+		clockPhase = 0;
+		clockPending++;
+	}
+	resetTracks();
+	handleTick();
+}
+
+
+/**
+ * Resets all tracks to the beginning of the song. The next call to "handleTick"
+ * will then load the state for the very first tick.
+ *
+ * @return void
+ */
+void SynthClass::resetTracks() {
+	byte i;
 
 	for (i = 0; i < trackCount; i++) {
-		note = currentNote[i];
-		if (note & SYNTH__NOTE_PAUSE) {
-			// When no note is not being played (silence) add the 0-line value 0x80
-			value += SYNTH__ANALOG_HALF;
+		loadTrack(trackState + i, tracks + i, 0);
+	}
+	currentTick = 0;
+}
+
+/**
+ * Copies the pointers of a track descriptor from program memory into the
+ * state of a track or sound effect. The track will continue with the note
+ * having the passed index. Its note will be a pause until the next tick.
+ *
+ * @param SYNTH_TRACK_STATE *state: The state to initialize
+ * @param SYNTH_TRACK *track: The track descriptor in program memory
+ * @param word index: The index of the next note to load
+ * @return void
+ */
+void SynthClass::loadTrack(SYNTH_TRACK_STATE *state, const SYNTH_TRACK *track, word index) {
+	const byte *notes = (const byte*) pgm_read_word( &(track->notes) );
+
+	state->note = notes + index;
+	state->noteEnd = notes + pgm_read_word( &(track->noteCount) );
+	state->timeOffset = (const word*) pgm_read_word( &(track->timeOffsets) ) + index;
+	state->currentNote = SYNTH__NOTE_PAUSE;		// Note 0x80 means pause;
+	state->duration = 0;
+	state->bend = 0;
+	state->flags = pgm_read_byte( &(track->flags) );
+	voicesChanged = true;
+}
+
+/**
+ * Loads the next event of a track or sound effect and advances its pointers.
+ * A note replaces the note being played. A pitch bend event only changes the
+ * pitch bend of the track so the note being played continues with the new
+ * pitch. A marker event changes nothing but gets reported.
+ *
+ * Pitch bend and marker events only exist in tracks having the according
+ * SYNTH__TRACK_* flag. Else every value above 0x7F is a pause (note off).
+ *
+ * @param SYNTH_TRACK_STATE *track: The track whose next event to load
+ * @return byte The SYNTH__EVENT_* type to report for the event or 0
+ */
+inline byte SynthClass::loadEvent(SYNTH_TRACK_STATE *track) {
+	byte event = pgm_read_byte( track->note++ );
+
+	track->timeOffset++;
+	if ((track->flags & SYNTH__TRACK_PITCH_BEND) && event >= SYNTH__PITCH_BEND) {
+		track->bend = event - SYNTH__PITCH_BEND_CENTER;
+		voicesChanged = true;
+		return 0;
+	}
+	if ((track->flags & SYNTH__TRACK_MARKERS) && event >= SYNTH__MARKER && event < SYNTH__PITCH_BEND) {
+		return SYNTH__EVENT_MARKER;
+	}
+	track->currentNote = event;
+	voicesChanged = true;
+	return (event & SYNTH__NOTE_PAUSE) ? 0 : SYNTH__EVENT_NOTE_ON;
+}
+
+/**
+ * Writes a pending MIDI clock byte to the UART if it is ready to send.
+ *
+ * @return void
+ */
+inline void SynthClass::sendClock() {
+	if (clockPending && (UCSR0A & _BV(UDRE0))) {
+		UDR0 = SYNTH__MIDI_CLOCK;
+		clockPending--;
+	}
+}
+
+/**
+ * Handles the MIDI clock at every tick. In follow mode the tick has to wait
+ * until enough clock bytes have been received. In output mode a clock byte
+ * is due whenever 1/24 quarter note has been played.
+ *
+ * @return bool Returns FALSE if the tick has to wait for the external clock
+ */
+inline bool SynthClass::handleClock() {
+	if (clockMode & SYNTH__CLOCK_FOLLOW) {
+		if (clockCredit < SYNTH__CLOCKS_PER_QUARTER_NOTE) {
+			sendClock();
+			return false;
+		}
+		clockCredit -= SYNTH__CLOCKS_PER_QUARTER_NOTE;
+	}
+	if (clockMode & SYNTH__CLOCK_OUTPUT) {
+		clockPhase += SYNTH__CLOCKS_PER_QUARTER_NOTE;
+		while (clockPhase >= ticksPerQuarterNote) {
+			clockPhase -= ticksPerQuarterNote;
+			clockPending++;
+		}
+		sendClock();
+	}
+	return true;
+}
+
+/**
+ * Puts an event into the event queue if its type has been selected using
+ * "setEvents". The event gets the time at which the current tick started.
+ * If the queue is full the event gets dropped. The event gets written
+ * completely before "eventWrite" gets advanced so "pollEvent" never reads
+ * an event being written.
+ *
+ * @param byte type: One of the SYNTH__EVENT_* types
+ * @param byte track: The track which caused the event
+ * @param byte value: The note or the marker event value (0xA0 - 0xBF)
+ * @return void
+ */
+void SynthClass::reportEvent(byte type, byte track, byte value) {
+	byte next = (eventWrite + 1) & (SYNTH__EVENT_QUEUE_LENGTH - 1);
+	SYNTH_EVENT *event;
+
+	if (!(type & eventMask) || next == eventRead) {
+		return;
+	}
+	event = events + eventWrite;
+	event->time = tickTime;
+	event->type = type;
+	event->track = track;
+	event->value = (type == SYNTH__EVENT_MARKER) ? value - SYNTH__MARKER : value;
+	SYNTH__MEMORY_BARRIER();
+	eventWrite = next;
+}
+
+/**
+ * Starts a new tick at the current sample after "seek" or "setLoop" have
+ * jumped to another tick. The part of the interrupted tick having been
+ * played already is added to the tick time so "getTime" keeps counting
+ * without a jump. Must get called with interrupts disabled.
+ *
+ * @return void
+ */
+void SynthClass::restartTick() {
+	tickTime += (unsigned long)(tickLength - sampleCounter) * pwmCyclesPerSample;
+	sampleCounter = samplesPerTick;
+	tickLength = sampleCounter;
+}
+
+/**
+ * This method determines the state all tracks would have at the specified
+ * tick. This is the implementation of "seek" and gets also used by "setLoop"
+ * to determine the state at the start of the loop region.
+ *
+ * The state gets written to the passed array instead of the state of the
+ * tracks. So this can run with interrupts enabled while the song continues.
+ * No events get reported and the end of the song is left to "handleTick".
+ *
+ * @param SYNTH_TRACK_STATE *state: Receives the state of every track
+ * @param unsigned long tick: The tick to which to seek
+ * @return void
+ */
+void SynthClass::seekTick(SYNTH_TRACK_STATE *state, unsigned long tick) {
+	byte i;
+	word low = 0;
+	word high = checkpointCount;
+	word middle;
+	unsigned long start = 0;
+	SYNTH_CHECKPOINT *checkpoint;
+
+	// Binary search for the first checkpoint after the requested tick. So the
+	// checkpoint before it ("low - 1") is the nearest one to start from.
+	while (low < high) {
+		middle = (low + high) >> 1;
+		if (pgm_read_dword( &(checkpoints[middle].tick) ) <= tick) {
+			low = middle + 1;
 		} else {
-			// First add the current sine amplitude to the total output value
-			// "Mix-in"
-      	value += getSineValue(currentPeriodIndex[i]);
+			high = middle;
+		}
+	}
 
+	if (low) {
+		checkpoint = checkpoints + low - 1;
+		for (i = 0; i < trackCount; i++) {
+			loadTrack(state + i, tracks + i, pgm_read_word( &(checkpoint->noteIndex[i]) ));
+			state[i].duration = pgm_read_word( &(checkpoint->duration[i]) );
+			state[i].currentNote = pgm_read_byte( &(checkpoint->note[i]) );
+			state[i].bend = pgm_read_byte( &(checkpoint->bend[i]) );
+		}
+		start = pgm_read_dword( &(checkpoint->tick) );
+	} else {
+		// There is no checkpoint before the requested tick. So the song
+		// has to get started from its very beginning. Like in the first
+		// tick of a song every track plays a pause until its first event.
+		for (i = 0; i < trackCount; i++) {
+			loadTrack(state + i, tracks + i, 0);
+			if (state[i].note < state[i].noteEnd) {
+				state[i].duration = pgm_read_word( state[i].timeOffset );
+			}
+		}
+	}
+	skipTicks(state, tick - start);
+}
 
-			// Now increment the period index according to the current note.
-			base = pgm_read_word(&SYNTH_periodBase[note]);
-			fraction = pgm_read_byte(&SYNTH_periodFraction[note]);
-	
-			currentPeriodIndex[i] += base;
-			currentPeriodFraction[i] += fraction;
+/**
+ * This method advances all tracks by the passed number of ticks without
+ * playing them. Unlike calling "handleTick" for every tick this only takes
+ * time for every note being skipped. The durations of the notes get simply
+ * subtracted from the number of ticks to skip.
+ *
+ * Ending a song is left to "handleTick" which will get called for the
+ * next tick.
+ *
+ * @param SYNTH_TRACK_STATE *state: The state of the tracks to advance
+ * @param unsigned long ticks: The number of ticks to skip
+ * @return void
+ */
+void SynthClass::skipTicks(SYNTH_TRACK_STATE *state, unsigned long ticks) {
+	byte i;
+	unsigned long remaining;
+	SYNTH_TRACK_STATE *track = state;
 
-			// When fraction overflows decrement it and increment index
-			if (currentPeriodFraction[i] > 0xFF) {
-				currentPeriodFraction[i] -= 0x100;
-				currentPeriodIndex[i]++;
+	for (i = 0; i < trackCount; i++, track++) {
+		remaining = ticks;
+		while (track->note < track->noteEnd) {
+			if (remaining < track->duration) {
+				// The current note is still playing after the skipped ticks
+				track->duration -= remaining;
+				break;
+			}
+			// Skip the rest of the current note and load the next one. This
+			// also takes care of notes having a zero event-time offset.
+			remaining -= track->duration;
+			loadEvent(track);
+			if (track->note < track->noteEnd) {
+				track->duration = pgm_read_word( track->timeOffset );
+			} else {
+				// The last note has been loaded. The track will get
+				// finished with the next tick.
+				track->duration = 0;
 			}
-			// We do not need to check for "index" overflowing 0x3FF. If this
-			// is the case we simply ignore it as it gets truncated in "getSineValue"
-			// anyways.
 		}
 	}
+}
+
 
+/**
+ * This method divides the sum of the sample values of "count" oscillators
+ * by "count" so the result fits into a byte again. If no oscillator has been
+ * mixed the 0-line value gets returned.
+ *
+ * @param word value: The sum of the sample values
+ * @param byte count: The number of sample values having been added
+ * @return byte The mixed sample value
+ */
+inline byte SynthClass::mixDown(word value, byte count) {
+	if (count == 0) {
+		return SYNTH__ANALOG_HALF;
+	}
 
 #if SYNTH__MAX_OSCILLATORS > 4
 	#error Mixer divide for more than four oscillators not implemented
 #endif
 
 #if SYNTH__MAX_OSCILLATORS > 2
-	if (trackCount == 3) {
-		// Is this too slow?
-		value = value / 3;
-	} else if (trackCount == 4) {
+	if (count == 3) {
+		// A division takes about 200 cycles on the AVR. Multiplying
+		// by 2^17 / 3 (rounded up) is exact for all possible sums.
+		value = ((unsigned long)value * 0xAAAB) >> 17;
+	} else if (count == 4) {
 		// Divide by four
 		value = value >> 2;
-	} else if (trackCount == 2) {
+	} else if (count == 2) {
 		// Divide by 2
 		value = value >> 1;
 	}
 #else
 	#if SYNTH__MAX_OSCILLATORS > 1
-		if (trackCount > 1) {
+		if (count > 1) {
 			// Divide by 2
 			value = value >> 1;
 		}
@@ -505,12 +1990,78 @@ byte SynthClass::calculateNextSampleValue() {
 	return (byte) value;
 }
 
+/**
+ * This method determines the next analog sample value which has to get written
+ * to the PWM (or external D/A). It does so by getting the current sine/pause
+ * value for each configured track, adding them together and then dividing the
+ * final result through the total number of tracks. This achieves a digital
+ * signal mixing.
+ *
+ * In dual output mode every oscillator gets added to the channels it has been
+ * routed to and every channel is divided by its own number of oscillators.
+ *
+ * In DAC16 mode the sum gets scaled to 16 bit by a multiplication instead of
+ * the division. So no resolution gets lost when mixing.
+ *
+ * @return word The next analog sample value. The high byte contains the value
+ *               for the second channel in dual output mode or the high byte
+ *               of the 16-bit value in DAC16 mode.
+ */
+word SynthClass::calculateNextSampleValue() {
+	byte a;
+	byte sample;
+	SYNTH_VOICE *voice;
+
+	// Oscillators not playing a note (silence) add the 0-line value 0x80.
+	// Their sum has been calculated in "updateVoices" already.
+	word value = silentValue[0];
+	word secondValue = silentValue[1];
+
+	for (a = 0; a < activeCount; a++) {
+		voice = activeVoices[a];
+		// Get the current amplitude which will get added to the
+		// total output value ("Mix-in") and advance the oscillator
+#if SYNTH__INTERPOLATION
+		if (interpolate && voice->interpolate) {
+			sample = getInterpolatedValue(voice);
+			advancePhase(voice);
+		} else
+#endif
+		{
+			sample = stepOscillator(voice);
+		}
+
+		if (voice->channels & SYNTH__CHANNEL_FIRST) {
+			value += sample;
+		}
+		if (voice->channels & SYNTH__CHANNEL_SECOND) {
+			secondValue += sample;
+		}
+	}
+
+	if (outputMode == SYNTH__OUTPUT_DAC16) {
+		if (!channelVoices[0]) {
+			return (word)SYNTH__ANALOG_HALF << 8;
+		}
+		// The 0-line stays at 0x8000 when effects add or remove oscillators.
+		// The product is signed but fits into 16 bit so unsigned wrap around
+		// gives the same result.
+		return (value - channelVoices[0] * SYNTH__ANALOG_HALF) * mixerGain + ((word)SYNTH__ANALOG_HALF << 8);
+	}
+
+	value = mixDown(value, channelVoices[0]);
+	if (outputMode == SYNTH__OUTPUT_DUAL) {
+		value |= (word)mixDown(secondValue, channelVoices[1]) << 8;
+	}
+	return value;
+}
+
 /**
  * This method handles SynthClass for the ISR.
  *
  * It write the next analog sample value to the PWM (or external DAC)
- * every SYNTH__PWM_CYCLES_PER_SAMPLE times. This will usually happen
- * 12500 times per second.
+ * every "pwmCyclesPerSample" times. This will happen between 12500
+ * and 31250 times per second depending on the song.
  *
  * If a sample has been written the next value for the sample will
  * get calculated.
@@ -528,9 +2079,14 @@ byte SynthClass::calculateNextSampleValue() {
  * @return void;
  */
 void SynthClass::handleIsr() {
+	byte i;
+
 	if (--pwmCounter == 0) {
 		*((byte*)sampleRegister) = nextSampleValue;
-		pwmCounter = SYNTH__PWM_CYCLES_PER_SAMPLE;
+		if (outputMode != SYNTH__OUTPUT_MONO) {
+			*((byte*)secondSampleRegister) = nextSampleValue >> 8;
+		}
+		pwmCounter = pwmCyclesPerSample;
 
 		// This hopefully always takes less than 256 CPU cycles
 		// Else calculating the next sample value would have to
@@ -539,23 +2095,61 @@ void SynthClass::handleIsr() {
 		// If the Arduino is not required to do anything other next
 		// to playing music this would be fine as it could be done
 		// in a main-routine loop waiting for the track finishing play.
-		nextSampleValue = calculateNextSampleValue();
+		if (activeCount) {
+			nextSampleValue = calculateNextSampleValue();
+		} else {
+			// During a rest only the samples and ticks get counted
+			nextSampleValue = idleSampleValue;
+		}
 
 		// Decrement sample counter. Whenever sampleCounter reaches zero
 		// this means a MIDI "tick" has occured.
 		// The overflow will get handled in next call to this interrupt
 		// routine where pwmCounter is surely not "0" after decrementing
-		// because it has been set to "SYNTH__PWM_CYCLES_PER_SAMPLE" in
+		// because it has been set to "pwmCyclesPerSample" in
 		// this block.
 		--sampleCounter;
 	} else if (sampleCounter == 0) {
 		// A tick has occured.
+		tickTime += (unsigned long)tickLength * pwmCyclesPerSample;
+		if (clockMode && !handleClock()) {
+			// Following an external clock which has not reached this
+			// tick yet. Check again with the next sample.
+			sampleCounter = 1;
+			tickLength = 1;
+			return;
+		}
 		sampleCounter = samplesPerTick;
+		tickFraction += samplesPerTickFraction;
+		if (tickFraction < samplesPerTickFraction) {
+			// The fractional part of the tick length has added up
+			// to a whole sample.
+			sampleCounter++;
+		}
+		if ((clockMode & SYNTH__CLOCK_FOLLOW) && clockCredit >= ticksPerQuarterNote) {
+			// The ticks of a whole clock byte are left after this
+			// tick. So the external clock is ahead. Catch up using
+			// shorter ticks.
+			sampleCounter -= sampleCounter >> 2;
+		}
+		tickLength = sampleCounter;
 
-		// If it can get assured that this method for itself will not take
-		// more than 256 CPU cycles then this is fine here.
-		// Else move to "play" routine.
-		handleTick();
+		if (++currentTick == loopEnd) {
+			// The end of the loop region has been reached. Instead of
+			// advancing the tracks continue at the start of the region
+			// using the state stored by "setLoop".
+			for (i = 0; i < trackCount; i++) {
+				trackState[i] = loopState[i];
+			}
+			currentTick = loopStart;
+			voicesChanged = true;
+		} else {
+			// If it can get assured that this method for itself will not take
+			// more than 256 CPU cycles then this is fine here.
+			// Else move to "play" routine.
+			handleTick();
+		}
+		handleEffects();
 	}
 }
 
@@ -572,4 +2166,3 @@ void SynthClass::handleIsr() {
 {
 	Synth.handleIsr();
 }
-
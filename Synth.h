@@ -7,8 +7,46 @@
 #define SYNTH__PWM_CYCLES_PER_SAMPLE		5			// 1/S
 #define SYNTH__SAMPLES_PER_SECOND			( SYNTH__PWM_FREQUENCY / SYNTH__PWM_CYCLES_PER_SAMPLE )		// S/s
 
+// Songs with few tracks get played at a higher sampling frequency. Down to
+// this number of PWM cycles per sample (31.25 kHz) may get used. Set it to
+// a value from 2 to 5. Note that "samplesPerTick" always refers to
+// SYNTH__SAMPLES_PER_SECOND (12.5 kHz).
+#define SYNTH__MIN_PWM_CYCLES_PER_SAMPLE	2			// 1/S
+
+// The increment tables in Synth.cpp only exist for these rates
+#if SYNTH__MIN_PWM_CYCLES_PER_SAMPLE < 2 || SYNTH__MIN_PWM_CYCLES_PER_SAMPLE > 5
+	#error SYNTH__MIN_PWM_CYCLES_PER_SAMPLE must be from 2 to 5
+#endif
+
 #define SYNTH__MAX_OSCILLATORS				4
 
+// Estimated CPU cycles for calculating a sample in the ISR. These have been
+// counted from the generated instructions (not measured on hardware) and
+// include the handling of a tick spread over the samples of the tick. They
+// are used to select the sampling frequency and to decide which optional
+// features fit into the time available for a sample. The ISR which
+// calculates a sample may take longer than one PWM period (256 cycles) as
+// the next overflow interrupt stays pending. But it must not take two.
+// Additionally the ISRs must leave some CPU time to the sketch.
+
+#define SYNTH__CYCLES_BUDGET					480		// Cycles available per sample
+#define SYNTH__CYCLES_PER_ISR					70			// Every ISR without a sample
+#define SYNTH__CYCLES_PER_SAMPLE				150		// ISR entry/exit and mixing
+#define SYNTH__CYCLES_PER_VOICE				80			// Oscillator and table lookup
+#define SYNTH__CYCLES_PER_INTERPOLATION	40			// Additional for interpolation
+#define SYNTH__CYCLES_PER_TICK				1000		// Tick with a new note in every track
+#define SYNTH__MAX_CPU_LOAD					75			// Percent used by the ISRs
+
+// Limits for "setTempoScale" in percent of the original tempo
+#define SYNTH__MIN_TEMPO_SCALE				10
+#define SYNTH__MAX_TEMPO_SCALE				1000
+
+// Number of songs which can get queued for gapless playing
+#define SYNTH__QUEUE_LENGTH					2
+
+// Number of sound effects which can get played on top of a song at once
+#define SYNTH__MAX_EFFECTS					1
+
 	// #define SYNTH__TICKS_PER_BEAT					96.0		// T/B
 	// #define SYNTH__BPM								120.0		// B/60s
 	// #define SYNTH__TICKS_PER_SECOND			( ( SYNTH__TICKS_PER_BEAT * SYNTH__BPM ) / 60.0 )		// T/s
@@ -26,6 +64,87 @@
 #define SYNTH__ANALOG_FULL			0xFF
 #define SYNTH__ANALOG_HALF			0x80
 
+// In tracks having the SYNTH__TRACK_PITCH_BEND flag set values of 0xC0 and above
+// in the notes are no notes (pauses) but pitch bend events. They change the pitch
+// of the note being played (and all following ones) by "value - 0xE0" sixteenths
+// of a semitone. So the range is -2 to +1 15/16 semitones. The event time of a
+// pitch bend event is given by the time offsets like for notes.
+#define SYNTH__TRACK_PITCH_BEND	0x01
+#define SYNTH__PITCH_BEND			0xC0
+#define SYNTH__PITCH_BEND_CENTER	0xE0
+
+// In tracks having the SYNTH__TRACK_MARKERS flag set values from 0xA0 to 0xBF
+// in the notes are marker events with the number "value - 0xA0". They do not
+// change the note being played but get reported as SYNTH__EVENT_MARKER.
+#define SYNTH__TRACK_MARKERS		0x02
+#define SYNTH__MARKER				0xA0
+
+// Types of the events reported by "pollEvent". They can get combined to
+// select the events to report using "setEvents".
+#define SYNTH__EVENT_NOTE_ON		0x01		// A track has started a note
+#define SYNTH__EVENT_MARKER		0x02		// A marker event has been reached
+#define SYNTH__EVENT_SONG_END		0x04		// A song has ended
+
+// Number of events which can be waiting for "pollEvent". Must be a power of
+// two. Further events get dropped until the sketch has fetched some.
+#define SYNTH__EVENT_QUEUE_LENGTH	8
+
+// MIDI clock modes for "setClock". In output mode a MIDI clock byte gets sent
+// on the UART 24 times per quarter note. In follow mode the ticks only advance
+// as far as allowed by the MIDI clock bytes passed to "midiClock". Their tick
+// length gets calculated from the average interval between the clock bytes so
+// the jitter of single clock bytes does not reach the audio output.
+#define SYNTH__CLOCK_INTERNAL		0x00
+#define SYNTH__CLOCK_OUTPUT		0x01
+#define SYNTH__CLOCK_FOLLOW		0x02
+#define SYNTH__MIDI_CLOCK			0xF8
+#define SYNTH__MIDI_BAUD_RATE		31250
+#define SYNTH__CLOCKS_PER_QUARTER_NOTE	24
+
+// The interval between the clock bytes is averaged over 2^n clock bytes
+#define SYNTH__CLOCK_SMOOTHING	3
+
+// Output modes. In mono mode all oscillators get mixed to a single pin. In dual
+// mode both pins 3 and 11 are used and every oscillator can get routed to the
+// first, the second or both of them (stereo or two independent audio zones).
+// In DAC16 mode both pins form a 16-bit D/A converter. The first pin outputs
+// the low byte and the second pin the high byte of the sample value. They have
+// to get summed using resistors with a ratio of 256:1 (low:high).
+#define SYNTH__OUTPUT_MONO			0
+#define SYNTH__OUTPUT_DUAL			1
+#define SYNTH__OUTPUT_DAC16		2
+
+// Waveforms which can get selected for each oscillator using "setWaveform".
+// All waveforms other than sine are stored as band-limited tables in program
+// memory (see SynthWaveTables.h) taking 2 KB per waveform. Setting
+// SYNTH__WAVETABLES to 0 removes them and leaves only the sine.
+#define SYNTH__WAVETABLES			1
+#define SYNTH__WAVE_SINE			0
+#define SYNTH__WAVE_SQUARE			1
+#define SYNTH__WAVE_SAWTOOTH		2
+
+// Number of band-limited tables per waveform. Every table holds half as many
+// harmonics as the previous one. So this is one table per octave. Notes too
+// high for the last table use it anyway. The tables in SynthWaveTables.h have
+// to get generated with the same number ("$levels" in waves.php).
+#define SYNTH__WAVE_LEVELS			8
+
+// Enables linear interpolation between the values of the sine and wave tables
+// for oscillators selected using "setInterpolation". The fraction of the phase
+// is used to calculate a value between two table entries. This costs about
+// SYNTH__CYCLES_PER_INTERPOLATION cycles per sample and oscillator. So it gets
+// only done if this fits into SYNTH__CYCLES_BUDGET for the number of
+// oscillators being played (usually less than four).
+//
+// Interpolation also allows to use smaller wave tables. Generate them with a
+// smaller "$tableSize" using "waves.php" to trade quality for program memory.
+#define SYNTH__INTERPOLATION		1
+
+// Output channel bits for "setVoiceOutput"
+#define SYNTH__CHANNEL_FIRST		0x01
+#define SYNTH__CHANNEL_SECOND		0x02
+#define SYNTH__CHANNEL_BOTH		( SYNTH__CHANNEL_FIRST | SYNTH__CHANNEL_SECOND )
+
 #if F_CPU != 16000000L
 	#error Timing tables have been precalculated for 16MHz. Compiling for different CPU frequency.
 #endif
@@ -45,15 +164,119 @@ typedef struct _SYNTH_TRACK
 	const byte *notes PROGMEM;
 	const word *timeOffsets PROGMEM;
 	const word noteCount PROGMEM;
+	const byte flags PROGMEM;				// SYNTH__TRACK_* flags
 } SYNTH_TRACK;
 
+// A checkpoint stores the state of every track at a certain tick of a song.
+// A sorted array of checkpoints gets generated by the MIDI converter script and
+// allows to start playing a song at an arbitrary tick (seek) or to loop a region
+// of a song without having to step through all the notes from its beginning.
+// The values are the ones which "handleTick" would have calculated for this tick.
+typedef struct _SYNTH_CHECKPOINT
+{
+	const unsigned long tick PROGMEM;
+	const word noteIndex[SYNTH__MAX_OSCILLATORS] PROGMEM;
+	const word duration[SYNTH__MAX_OSCILLATORS] PROGMEM;
+	const byte note[SYNTH__MAX_OSCILLATORS] PROGMEM;
+	const int8_t bend[SYNTH__MAX_OSCILLATORS] PROGMEM;
+} SYNTH_CHECKPOINT;
+
+// The state of a track or sound effect being played. When a track gets started
+// the pointers of its descriptor get copied from program memory. So a tick only
+// has to advance the pointers instead of reading the descriptor again and
+// calculating addresses from a note index.
+typedef struct _SYNTH_TRACK_STATE
+{
+	const byte *note;				// The next note to load (program memory)
+	const byte *noteEnd;			// Behind the last note of the track
+	const word *timeOffset;		// The event time of the next note
+	word duration;					// Ticks until the next note gets loaded
+	byte currentNote;				// The note being played
+	int8_t bend;					// Pitch bend in 1/16 semitones
+	byte flags;						// SYNTH__TRACK_* flags of the track
+} SYNTH_TRACK_STATE;
+
+// The state of an oscillator. The increment of the phase per sample gets
+// looked up when a note gets loaded so calculating a sample only needs data
+// memory accesses relative to a single pointer. Pitch bend and fine tuning get
+// applied to the increment when it gets looked up.
+typedef struct _SYNTH_VOICE
+{
+	word phase;						// Position in the period (1024 steps)
+	byte phaseFraction;			// Fraction of a step (1/256)
+	word increment;				// Steps per sample for the current note
+	byte incrementFraction;		// Fraction of the steps per sample
+	const byte *table;			// Band-limited wave table or NULL for sine
+	byte waveform;					// One of the SYNTH__WAVE_* values
+	byte channels;					// Output channels (SYNTH__CHANNEL_*)
+	byte output;					// Channels set by "setVoiceOutput"
+	bool interpolate;				// Whether interpolation has been requested
+	int8_t detune;					// Fine tuning in 1/16 semitones
+} SYNTH_VOICE;
+
+// An event reported to the sketch by "pollEvent". The time is counted in PWM
+// periods (1/62500 s) since the song was started using "play". So it does not
+// depend on the sampling frequency and can get compared to "getTime".
+typedef struct _SYNTH_EVENT
+{
+	unsigned long time;			// The time at which the event occured
+	byte type;						// One of the SYNTH__EVENT_* types
+	byte track;						// The track which caused the event
+	byte value;						// The note or marker number
+} SYNTH_EVENT;
+
+// A song waiting in the queue. Contains the parameters which have been
+// passed to "enqueue".
+// The sampling frequency and tick length selected for a song and the
+// cycles left for calculating a sample at them. These get calculated
+// before the song starts so the ISR only has to copy them.
+typedef struct _SYNTH_RATE
+{
+	byte pwmCyclesPerSample;
+	word samplesPerTick;
+	byte samplesPerTickFraction;
+	word cycleLimit;
+} SYNTH_RATE;
+
+typedef struct _SYNTH_SONG
+{
+	SYNTH_TRACK *tracks;
+	byte trackCount;
+	word samplesPerTick;
+	SYNTH_CHECKPOINT *checkpoints;
+	word checkpointCount;
+	SYNTH_RATE rate;
+} SYNTH_SONG;
+
 class SynthClass {
 
 	private:
 	// Private methods. See implementation for inline documentation
 	byte getSineValue(word index);
-	byte calculateNextSampleValue();
+	byte getInterpolatedValue(SYNTH_VOICE *voice);
+	void advancePhase(SYNTH_VOICE *voice);
+	byte stepOscillator(SYNTH_VOICE *voice);
+	byte mixDown(word value, byte count);
+	word calculateNextSampleValue();
+	intptr_t enablePin(uint8_t pin);
 	void handleTick();
+	void resetTracks();
+	void loadTrack(SYNTH_TRACK_STATE *state, const SYNTH_TRACK *track, word index);
+	void nextSong();
+	void handleEffects();
+	void updateVoices();
+	bool loadVoice(SYNTH_VOICE *voice, byte note, int8_t bend);
+	byte loadEvent(SYNTH_TRACK_STATE *track);
+	void reportEvent(byte type, byte track, byte value);
+	void sendClock();
+	bool handleClock();
+	void selectSampleRate(SYNTH_RATE *rate, byte _trackCount, word _samplesPerTick);
+	void calculateTickLength(SYNTH_RATE *rate, word _samplesPerTick);
+	void applyRate(const SYNTH_RATE *rate);
+	void updateTempo();
+	void seekTick(SYNTH_TRACK_STATE *state, unsigned long tick);
+	void skipTicks(SYNTH_TRACK_STATE *state, unsigned long ticks);
+	void restartTick();
 
 	/*****************************
 	 ** TRACK VARIABLES
@@ -65,32 +288,117 @@ class SynthClass {
 	// This determines the speed of a song. It defines the length of
 	// a midi tick (clock) in samples. So making this value larger
 	// will result in slower play.
+	// The value passed to "play" refers to a sampling frequency of
+	// SYNTH__SAMPLES_PER_SECOND. "samplesPerTick" and its fraction
+	// (1/256 samples) are the tick length for the selected sampling
+	// frequency.
+	word songSamplesPerTick;
 	word samplesPerTick;
+	byte samplesPerTickFraction;
+
+	// The tempo in percent of the tempo given by "samplesPerTick"
+	// and the number of semitones by which all tracks get
+	// transposed. Both get applied at tick time.
+	word tempoScale;
+	int8_t transpose;
 
 	// Points to the tracks which should get played
 	SYNTH_TRACK *tracks;
 
+	// Points to the (optional) checkpoint index of the song being
+	// played. Used by "seek" to find the nearest checkpoint before
+	// the requested tick using a binary search.
+	SYNTH_CHECKPOINT *checkpoints;
+	word checkpointCount;
+
+	// Number of ticks having elapsed since the song was started.
+	unsigned long currentTick;
+
+	// When "loopEnd" is reached playing will continue at "loopStart"
+	// A "loopEnd" value of zero disables looping.
+	unsigned long loopStart;
+	unsigned long loopEnd;
+
+	// The state of every track at "loopStart". It gets determined by
+	// "setLoop" so jumping back only requires copying it.
+	SYNTH_TRACK_STATE loopState[SYNTH__MAX_OSCILLATORS];
+
+	// Songs which will get played after the current one has ended.
+	// The ISR reads at "queueRead" and "enqueue" writes at "queueWrite".
+	// The queue is empty when both are equal so one entry stays unused.
+	SYNTH_SONG queue[SYNTH__QUEUE_LENGTH + 1];
+	byte queueRead;
+	byte queueWrite;
+
 
 	/*****************************
 	 ** OSCILLATORS VARIABLES
 	 ****************************/
 
-	// This variable array contains the index of the
-	// note in its track. If a track reaches its last
-	// note (noteIndex >= noteCount) the track will
-	// continue to play a pause.
-	word noteIndex[SYNTH__MAX_OSCILLATORS];
+	// The state of every track. If a track reaches its last
+	// note (note >= noteEnd) the track will continue to
+	// play a pause.
+	SYNTH_TRACK_STATE trackState[SYNTH__MAX_OSCILLATORS];
+
+	// The state of every oscillator. An oscillator plays the
+	// current note of the track with the same number or the
+	// current note of a sound effect having taken it over.
+	SYNTH_VOICE voices[SYNTH__MAX_OSCILLATORS];
+
+	// Number of oscillators which get mixed together. This is
+	// the number of tracks plus any oscillator being used by
+	// a sound effect in addition to the tracks.
+	byte voiceCount;
+
+	// The oscillators which are actually sounding. Only those
+	// get calculated for every sample. The oscillators of tracks
+	// being in a pause only add the 0-line value to the channels
+	// they are routed to. This sum gets precalculated at tick time.
+	SYNTH_VOICE *activeVoices[SYNTH__MAX_OSCILLATORS];
+	byte activeCount;
+	word silentValue[2];
+
+	// The sample value being output when no oscillator is sounding.
+	// No sample has to get calculated in this case.
+	word idleSampleValue;
+
+	// Events which have not been fetched by "pollEvent" yet. The ISR
+	// writes at "eventWrite" and "pollEvent" reads at "eventRead". So
+	// each index only gets modified by one side and no locking is
+	// necessary. Only the types in "eventMask" get reported.
+	SYNTH_EVENT events[SYNTH__EVENT_QUEUE_LENGTH];
+	volatile byte eventRead;
+	volatile byte eventWrite;
+	byte eventMask;
+
+	// Whether interpolation fits into the cycle budget currently
+	bool interpolate;
+
+	// Set whenever a note, pitch bend or oscillator setting has changed.
+	// The voices only get updated at the next tick if this is set.
+	volatile bool voicesChanged;
+
+	// The number of oscillators being mixed to each of both
+	// output channels.
+	byte channelVoices[2];
+
+	// The factor by which the sum of all oscillators relative
+	// to their 0-line gets multiplied to fill the 16-bit range
+	// in DAC16 mode.
+	word mixerGain;
 
-	// Those variables contain the current note and
-	// duration which is being played by each oscillator.
-	byte currentNote[SYNTH__MAX_OSCILLATORS];
-	word currentDuration[SYNTH__MAX_OSCILLATORS];
 
-	// Those variables contain the current period
-	// position (offset in the sine wave) for each
-	// oscillator.
-	word currentPeriodIndex[SYNTH__MAX_OSCILLATORS];
-	word currentPeriodFraction[SYNTH__MAX_OSCILLATORS];
+	/*****************************
+	 ** SOUND EFFECT VARIABLES
+	 ****************************/
+
+	// The state of each sound effect being played. It has the
+	// same meaning as the one for the tracks above. An effect
+	// slot is free when its note pointer is NULL.
+	SYNTH_TRACK_STATE effectState[SYNTH__MAX_EFFECTS];
+
+	// The oscillator being used by each sound effect
+	byte effectVoice[SYNTH__MAX_EFFECTS];
 
 
 	/*****************************
@@ -105,29 +413,115 @@ class SynthClass {
 	// interval.
 	// After the value has been written to PWM pin the next
 	// value for it will get calculated.
-	byte nextSampleValue;
+	// The low byte is the value for the first channel and
+	// the high byte the one for the second channel.
+	word nextSampleValue;
 
 	// Counts number of interrupts until PWM gets updated
 	// with a new value (sample period). So this variable
-	// will become zero 12500 times a second.
+	// will become zero 12500 to 31250 times a second.
 	byte pwmCounter;
 
+	// The number of PWM cycles per sample selected for the
+	// song being played and the increment tables for the
+	// resulting sampling frequency.
+	byte pwmCyclesPerSample;
+	const word *periodBase;
+	const byte *periodFraction;
+
+	// The cycles calculating a sample may take at the selected
+	// sampling frequency. Interpolation only gets enabled if the
+	// estimated cycles of the active voices stay below.
+	word cycleLimit;
+
 	// Counts number of samples having been played. After
 	// "SYNTH_SAMPLES_PER_TICK" samples being played this
 	// variable will reach zero and a tick will get issued.
 	word sampleCounter;
 
+	// Accumulates "samplesPerTickFraction". Whenever it
+	// overflows a tick gets one sample longer.
+	byte tickFraction;
+
+	// The length of the current tick in samples and the time
+	// at which it started in PWM periods since "play".
+	word tickLength;
+	unsigned long tickTime;
+
 	// Defines the register which to use to output a
 	// sample value. Will usually be the PWM register
 	// for the selected pin.
 	intptr_t sampleRegister;
 
+	// The register of the second channel in dual output mode
+	intptr_t secondSampleRegister;
+
+	// One of the SYNTH__OUTPUT_* modes
+	byte outputMode;
+
+
+	/*****************************
+	 ** MIDI CLOCK VARIABLES
+	 ****************************/
+
+	// The SYNTH__CLOCK_* flags passed to "setClock" and the number of
+	// ticks per quarter note of the songs.
+	byte clockMode;
+	word ticksPerQuarterNote;
+
+	// Counts SYNTH__CLOCKS_PER_QUARTER_NOTE for every tick. Whenever it
+	// exceeds "ticksPerQuarterNote" a clock byte is due. Clock bytes
+	// wait in "clockPending" while the UART is still busy.
+	word clockPhase;
+	byte clockPending;
+
+	// Follow mode: Every clock byte adds "ticksPerQuarterNote" and every
+	// tick takes SYNTH__CLOCKS_PER_QUARTER_NOTE. A tick has to wait if
+	// there is not enough credit left.
+	volatile word clockCredit;
+
+	// Follow mode: The time of the last clock byte and the average time
+	// between clock bytes multiplied by 2^SYNTH__CLOCK_SMOOTHING. Both
+	// are in PWM periods. The average is zero until two clock bytes
+	// have been received.
+	unsigned long lastClockTime;
+	unsigned long clockInterval;
+	bool clockStarted;
+
+	// Follow mode: The tick length resulting from the clock in PWM periods
+	// with 8 fractional bits. It replaces the tempo of the song in
+	// "calculateTickLength" so changing the tempo scale or the sampling frequency
+	// does not lose it. Zero until two clock bytes have been received.
+	unsigned long clockTickLength;
+
 	// Public methods which can get called from an Arduino sketch
 	public:
-	void init(uint8_t pin);
-	void play(const SYNTH_TRACK *_tracks, byte _trackCount, word _samplesPerTick);
+	void init(uint8_t pin, uint8_t secondPin = 0, byte mode = SYNTH__OUTPUT_DUAL);
+	void setVoiceOutput(byte voice, byte channels);
+	void setWaveform(byte voice, byte waveform);
+	void setInterpolation(byte voice, bool enable);
+	void setTranspose(int8_t semitones);
+	void setDetune(byte voice, int8_t sixteenths);
+	void setTempoScale(word percent);
+	void play(const SYNTH_TRACK *_tracks, byte _trackCount, word _samplesPerTick, const SYNTH_CHECKPOINT *_checkpoints = NULL, word _checkpointCount = 0);
+	bool enqueue(const SYNTH_TRACK *_tracks, byte _trackCount, word _samplesPerTick, const SYNTH_CHECKPOINT *_checkpoints = NULL, word _checkpointCount = 0);
+	byte queued();
+	bool playEffect(const SYNTH_TRACK *effect, word _samplesPerTick);
+	void seek(unsigned long tick);
+	void setLoop(unsigned long startTick, unsigned long endTick);
+	unsigned long getTick();
+	unsigned long getTime();
+	void setEvents(byte mask);
+	bool pollEvent(SYNTH_EVENT *event);
+	void setClock(byte mode, word _ticksPerQuarterNote);
+	void midiClock(byte data);
 	void stop();
 	bool isPlaying();
+	bool isSilent();
+	byte getVoiceCount();
+	word getSampleRate();
+	word getCycles();
+	void sleep();
 	void handleIsr();
 
 };
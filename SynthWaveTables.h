@@ -0,0 +1,328 @@
+// This file has been generated by "resources/scripts/waves.php". Do not edit.
+//
+// Band-limited wave tables for the waveforms other than sine. Every waveform
+// has 8 tables of one period each. Table N contains at most 128 >> N harmonics.
+
+// Every table has 2 ^ SYNTH__WAVE_TABLE_BITS values. To change the size set
+// $tableSize in waves.php and regenerate this file.
+#define SYNTH__WAVE_TABLE_BITS	8
+
+// The number of tables per waveform. Set $levels in waves.php to change it.
+#define SYNTH__WAVE_TABLE_LEVELS	8
+
+#if SYNTH__WAVE_TABLE_LEVELS != SYNTH__WAVE_LEVELS
+	#error SYNTH__WAVE_LEVELS does not match the number of generated wave tables
+#endif
+
+const byte SYNTH_waveTables[2][SYNTH__WAVE_LEVELS][1 << SYNTH__WAVE_TABLE_BITS] PROGMEM = {
+	// SQUARE
+	{
+		// 127 harmonics
+		{
+			128, 255, 225, 243, 230, 240, 232, 239, 233, 238, 234, 238, 234, 237, 234, 237, 
+			234, 237, 234, 237, 235, 237, 235, 237, 235, 237, 235, 237, 235, 237, 235, 236, 
+			235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 
+			235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 
+			235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 
+			235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 235, 236, 
+			235, 236, 235, 237, 235, 237, 235, 237, 235, 237, 235, 237, 235, 237, 234, 237, 
+			234, 237, 234, 237, 234, 238, 234, 238, 233, 239, 232, 240, 230, 243, 225, 255, 
+			128, 1, 31, 13, 26, 16, 24, 17, 23, 18, 22, 18, 22, 19, 22, 19, 
+			22, 19, 22, 19, 21, 19, 21, 19, 21, 19, 21, 19, 21, 19, 21, 20, 
+			21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 
+			21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 
+			21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 
+			21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 21, 20, 
+			21, 20, 21, 19, 21, 19, 21, 19, 21, 19, 21, 19, 21, 19, 22, 19, 
+			22, 19, 22, 19, 22, 18, 22, 18, 23, 17, 24, 16, 26, 13, 31, 1
+		},
+		// 64 harmonics
+		{
+			128, 222, 255, 238, 225, 235, 243, 236, 230, 235, 240, 236, 232, 236, 239, 236, 
+			233, 236, 238, 236, 233, 236, 238, 236, 234, 236, 238, 236, 234, 236, 237, 236, 
+			234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236, 
+			235, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236, 
+			235, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236, 
+			235, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236, 
+			234, 236, 237, 236, 234, 236, 238, 236, 234, 236, 238, 236, 233, 236, 238, 236, 
+			233, 236, 239, 236, 232, 236, 240, 235, 230, 236, 243, 235, 225, 238, 255, 222, 
+			128, 34, 1, 18, 31, 21, 13, 20, 26, 21, 16, 20, 24, 20, 17, 20, 
+			23, 20, 18, 20, 23, 20, 18, 20, 22, 20, 18, 20, 22, 20, 19, 20, 
+			22, 20, 19, 20, 22, 20, 19, 20, 22, 20, 19, 20, 22, 20, 19, 20, 
+			21, 20, 19, 20, 21, 20, 19, 20, 21, 20, 19, 20, 21, 20, 19, 20, 
+			21, 20, 19, 20, 21, 20, 19, 20, 21, 20, 19, 20, 21, 20, 19, 20, 
+			21, 20, 19, 20, 22, 20, 19, 20, 22, 20, 19, 20, 22, 20, 19, 20, 
+			22, 20, 19, 20, 22, 20, 18, 20, 22, 20, 18, 20, 23, 20, 18, 20, 
+			23, 20, 17, 20, 24, 20, 16, 21, 26, 20, 13, 21, 31, 18, 1, 34
+		},
+		// 32 harmonics
+		{
+			128, 180, 222, 247, 255, 249, 238, 229, 225, 228, 235, 241, 243, 241, 236, 232, 
+			230, 232, 235, 239, 240, 239, 236, 233, 232, 233, 236, 238, 239, 238, 236, 234, 
+			233, 234, 236, 238, 238, 238, 236, 234, 233, 234, 236, 237, 238, 237, 236, 234, 
+			233, 234, 236, 237, 238, 237, 236, 234, 234, 234, 236, 237, 238, 237, 236, 234, 
+			234, 234, 236, 237, 238, 237, 236, 234, 234, 234, 236, 237, 238, 237, 236, 234, 
+			233, 234, 236, 237, 238, 237, 236, 234, 233, 234, 236, 238, 238, 238, 236, 234, 
+			233, 234, 236, 238, 239, 238, 236, 233, 232, 233, 236, 239, 240, 239, 235, 232, 
+			230, 232, 236, 241, 243, 241, 235, 228, 225, 229, 238, 249, 255, 247, 222, 180, 
+			128, 76, 34, 9, 1, 7, 18, 27, 31, 28, 21, 15, 13, 15, 20, 24, 
+			26, 24, 21, 17, 16, 17, 20, 23, 24, 23, 20, 18, 17, 18, 20, 22, 
+			23, 22, 20, 18, 18, 18, 20, 22, 23, 22, 20, 19, 18, 19, 20, 22, 
+			23, 22, 20, 19, 18, 19, 20, 22, 22, 22, 20, 19, 18, 19, 20, 22, 
+			22, 22, 20, 19, 18, 19, 20, 22, 22, 22, 20, 19, 18, 19, 20, 22, 
+			23, 22, 20, 19, 18, 19, 20, 22, 23, 22, 20, 18, 18, 18, 20, 22, 
+			23, 22, 20, 18, 17, 18, 20, 23, 24, 23, 20, 17, 16, 17, 21, 24, 
+			26, 24, 20, 15, 13, 15, 21, 28, 31, 27, 18, 7, 1, 9, 34, 76
+		},
+		// 16 harmonics
+		{
+			128, 155, 180, 203, 222, 237, 247, 253, 255, 253, 249, 244, 238, 233, 228, 226, 
+			225, 226, 228, 231, 235, 238, 241, 243, 243, 243, 241, 239, 236, 234, 231, 230, 
+			230, 230, 231, 233, 235, 237, 239, 240, 241, 240, 239, 238, 236, 234, 232, 231, 
+			231, 231, 232, 234, 236, 237, 239, 240, 240, 240, 239, 237, 236, 234, 233, 232, 
+			231, 232, 233, 234, 236, 237, 239, 240, 240, 240, 239, 237, 236, 234, 232, 231, 
+			231, 231, 232, 234, 236, 238, 239, 240, 241, 240, 239, 237, 235, 233, 231, 230, 
+			230, 230, 231, 234, 236, 239, 241, 243, 243, 243, 241, 238, 235, 231, 228, 226, 
+			225, 226, 228, 233, 238, 244, 249, 253, 255, 253, 247, 237, 222, 203, 180, 155, 
+			128, 101, 76, 53, 34, 19, 9, 3, 1, 3, 7, 12, 18, 23, 28, 30, 
+			31, 30, 28, 25, 21, 18, 15, 13, 13, 13, 15, 17, 20, 22, 25, 26, 
+			26, 26, 25, 23, 21, 19, 17, 16, 15, 16, 17, 18, 20, 22, 24, 25, 
+			25, 25, 24, 22, 20, 19, 17, 16, 16, 16, 17, 19, 20, 22, 23, 24, 
+			25, 24, 23, 22, 20, 19, 17, 16, 16, 16, 17, 19, 20, 22, 24, 25, 
+			25, 25, 24, 22, 20, 18, 17, 16, 15, 16, 17, 19, 21, 23, 25, 26, 
+			26, 26, 25, 22, 20, 17, 15, 13, 13, 13, 15, 18, 21, 25, 28, 30, 
+			31, 30, 28, 23, 18, 12, 7, 3, 1, 3, 9, 19, 34, 53, 76, 101
+		},
+		// 8 harmonics
+		{
+			128, 141, 155, 167, 180, 192, 203, 213, 222, 230, 237, 243, 247, 251, 253, 255, 
+			255, 255, 253, 252, 249, 247, 244, 241, 238, 235, 232, 229, 227, 226, 225, 224, 
+			224, 224, 225, 226, 227, 229, 230, 232, 234, 236, 238, 240, 242, 243, 244, 244, 
+			244, 244, 244, 243, 242, 240, 239, 237, 235, 234, 232, 231, 229, 228, 227, 227, 
+			227, 227, 227, 228, 229, 231, 232, 234, 235, 237, 239, 240, 242, 243, 244, 244, 
+			244, 244, 244, 243, 242, 240, 238, 236, 234, 232, 230, 229, 227, 226, 225, 224, 
+			224, 224, 225, 226, 227, 229, 232, 235, 238, 241, 244, 247, 249, 252, 253, 255, 
+			255, 255, 253, 251, 247, 243, 237, 230, 222, 213, 203, 192, 180, 167, 155, 141, 
+			128, 115, 101, 89, 76, 64, 53, 43, 34, 26, 19, 13, 9, 5, 3, 1, 
+			1, 1, 3, 4, 7, 9, 12, 15, 18, 21, 24, 27, 29, 30, 31, 32, 
+			32, 32, 31, 30, 29, 27, 26, 24, 22, 20, 18, 16, 14, 13, 12, 12, 
+			12, 12, 12, 13, 14, 16, 17, 19, 21, 22, 24, 25, 27, 28, 29, 29, 
+			29, 29, 29, 28, 27, 25, 24, 22, 21, 19, 17, 16, 14, 13, 12, 12, 
+			12, 12, 12, 13, 14, 16, 18, 20, 22, 24, 26, 27, 29, 30, 31, 32, 
+			32, 32, 31, 30, 29, 27, 24, 21, 18, 15, 12, 9, 7, 4, 3, 1, 
+			1, 1, 3, 5, 9, 13, 19, 26, 34, 43, 53, 64, 76, 89, 101, 115
+		},
+		// 4 harmonics
+		{
+			128, 135, 141, 148, 154, 161, 167, 173, 179, 185, 191, 196, 202, 207, 212, 217, 
+			221, 225, 229, 233, 236, 239, 242, 245, 247, 249, 251, 252, 253, 254, 255, 255, 
+			255, 255, 255, 254, 253, 252, 251, 250, 249, 247, 246, 244, 242, 241, 239, 237, 
+			235, 233, 232, 230, 228, 227, 225, 224, 223, 222, 221, 220, 219, 219, 218, 218, 
+			218, 218, 218, 219, 219, 220, 221, 222, 223, 224, 225, 227, 228, 230, 232, 233, 
+			235, 237, 239, 241, 242, 244, 246, 247, 249, 250, 251, 252, 253, 254, 255, 255, 
+			255, 255, 255, 254, 253, 252, 251, 249, 247, 245, 242, 239, 236, 233, 229, 225, 
+			221, 217, 212, 207, 202, 196, 191, 185, 179, 173, 167, 161, 154, 148, 141, 135, 
+			128, 121, 115, 108, 102, 95, 89, 83, 77, 71, 65, 60, 54, 49, 44, 39, 
+			35, 31, 27, 23, 20, 17, 14, 11, 9, 7, 5, 4, 3, 2, 1, 1, 
+			1, 1, 1, 2, 3, 4, 5, 6, 7, 9, 10, 12, 14, 15, 17, 19, 
+			21, 23, 24, 26, 28, 29, 31, 32, 33, 34, 35, 36, 37, 37, 38, 38, 
+			38, 38, 38, 37, 37, 36, 35, 34, 33, 32, 31, 29, 28, 26, 24, 23, 
+			21, 19, 17, 15, 14, 12, 10, 9, 7, 6, 5, 4, 3, 2, 1, 1, 
+			1, 1, 1, 2, 3, 4, 5, 7, 9, 11, 14, 17, 20, 23, 27, 31, 
+			35, 39, 44, 49, 54, 60, 65, 71, 77, 83, 89, 95, 102, 108, 115, 121
+		},
+		// 2 harmonics
+		{
+			128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174, 
+			177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211, 213, 216, 
+			218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240, 241, 243, 244, 
+			245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255, 
+			255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246, 
+			245, 244, 243, 241, 240, 239, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220, 
+			218, 216, 213, 211, 209, 206, 204, 201, 199, 196, 193, 191, 188, 185, 182, 179, 
+			177, 174, 171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 140, 137, 134, 131, 
+			128, 125, 122, 119, 116, 112, 109, 106, 103, 100, 97, 94, 91, 88, 85, 82, 
+			79, 77, 74, 71, 68, 65, 63, 60, 57, 55, 52, 50, 47, 45, 43, 40, 
+			38, 36, 34, 32, 30, 28, 26, 24, 22, 21, 19, 17, 16, 15, 13, 12, 
+			11, 10, 8, 7, 6, 6, 5, 4, 3, 3, 2, 2, 2, 1, 1, 1, 
+			1, 1, 1, 1, 2, 2, 2, 3, 3, 4, 5, 6, 6, 7, 8, 10, 
+			11, 12, 13, 15, 16, 17, 19, 21, 22, 24, 26, 28, 30, 32, 34, 36, 
+			38, 40, 43, 45, 47, 50, 52, 55, 57, 60, 63, 65, 68, 71, 74, 77, 
+			79, 82, 85, 88, 91, 94, 97, 100, 103, 106, 109, 112, 116, 119, 122, 125
+		},
+		// 1 harmonics
+		{
+			128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174, 
+			177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211, 213, 216, 
+			218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240, 241, 243, 244, 
+			245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255, 
+			255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246, 
+			245, 244, 243, 241, 240, 239, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220, 
+			218, 216, 213, 211, 209, 206, 204, 201, 199, 196, 193, 191, 188, 185, 182, 179, 
+			177, 174, 171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 140, 137, 134, 131, 
+			128, 125, 122, 119, 116, 112, 109, 106, 103, 100, 97, 94, 91, 88, 85, 82, 
+			79, 77, 74, 71, 68, 65, 63, 60, 57, 55, 52, 50, 47, 45, 43, 40, 
+			38, 36, 34, 32, 30, 28, 26, 24, 22, 21, 19, 17, 16, 15, 13, 12, 
+			11, 10, 8, 7, 6, 6, 5, 4, 3, 3, 2, 2, 2, 1, 1, 1, 
+			1, 1, 1, 1, 2, 2, 2, 3, 3, 4, 5, 6, 6, 7, 8, 10, 
+			11, 12, 13, 15, 16, 17, 19, 21, 22, 24, 26, 28, 30, 32, 34, 36, 
+			38, 40, 43, 45, 47, 50, 52, 55, 57, 60, 63, 65, 68, 71, 74, 77, 
+			79, 82, 85, 88, 91, 94, 97, 100, 103, 106, 109, 112, 116, 119, 122, 125
+		},
+	},
+	// SAWTOOTH
+	{
+		// 127 harmonics
+		{
+			128, 129, 130, 131, 131, 132, 133, 134, 135, 136, 136, 137, 138, 139, 140, 141, 
+			142, 142, 143, 144, 145, 146, 147, 148, 148, 149, 150, 151, 152, 153, 153, 154, 
+			155, 156, 157, 158, 158, 159, 160, 161, 162, 163, 163, 165, 165, 166, 167, 168, 
+			168, 170, 170, 171, 172, 173, 174, 175, 175, 177, 177, 178, 179, 180, 180, 182, 
+			182, 183, 184, 185, 185, 187, 187, 188, 189, 190, 190, 192, 192, 194, 194, 195, 
+			195, 197, 197, 199, 199, 200, 200, 202, 202, 204, 204, 206, 205, 207, 207, 209, 
+			209, 211, 210, 213, 212, 214, 214, 216, 215, 218, 217, 220, 218, 221, 220, 223, 
+			222, 225, 223, 227, 224, 229, 226, 231, 227, 234, 228, 237, 228, 241, 224, 255, 
+			128, 1, 32, 15, 28, 19, 28, 22, 29, 25, 30, 27, 32, 29, 33, 31, 
+			34, 33, 36, 35, 38, 36, 39, 38, 41, 40, 42, 42, 44, 43, 46, 45, 
+			47, 47, 49, 49, 51, 50, 52, 52, 54, 54, 56, 56, 57, 57, 59, 59, 
+			61, 61, 62, 62, 64, 64, 66, 66, 67, 68, 69, 69, 71, 71, 72, 73, 
+			74, 74, 76, 76, 77, 78, 79, 79, 81, 81, 82, 83, 84, 85, 86, 86, 
+			88, 88, 89, 90, 91, 91, 93, 93, 94, 95, 96, 97, 98, 98, 99, 100, 
+			101, 102, 103, 103, 104, 105, 106, 107, 108, 108, 109, 110, 111, 112, 113, 114, 
+			114, 115, 116, 117, 118, 119, 120, 120, 121, 122, 123, 124, 125, 125, 126, 127
+		},
+		// 64 harmonics
+		{
+			128, 128, 130, 131, 131, 132, 133, 135, 135, 135, 137, 138, 138, 139, 140, 141, 
+			142, 142, 143, 145, 145, 145, 147, 148, 148, 149, 150, 152, 152, 152, 154, 155, 
+			155, 156, 157, 158, 158, 159, 161, 162, 162, 162, 164, 165, 165, 166, 168, 169, 
+			169, 169, 171, 172, 172, 173, 174, 175, 175, 176, 178, 179, 179, 179, 181, 182, 
+			182, 183, 185, 186, 185, 186, 188, 189, 189, 190, 192, 192, 192, 193, 195, 196, 
+			195, 197, 199, 199, 199, 200, 202, 203, 202, 203, 206, 206, 205, 207, 209, 210, 
+			209, 210, 213, 213, 212, 214, 217, 216, 215, 217, 220, 220, 218, 221, 224, 223, 
+			221, 224, 228, 226, 223, 227, 233, 230, 225, 231, 239, 232, 223, 237, 255, 223, 
+			128, 33, 1, 19, 33, 24, 17, 25, 31, 26, 23, 29, 33, 30, 28, 32, 
+			35, 33, 32, 35, 38, 36, 36, 39, 41, 40, 39, 42, 44, 43, 43, 46, 
+			47, 46, 47, 49, 51, 50, 50, 53, 54, 53, 54, 56, 57, 57, 57, 59, 
+			61, 60, 61, 63, 64, 64, 64, 66, 67, 67, 68, 70, 71, 70, 71, 73, 
+			74, 74, 75, 77, 77, 77, 78, 80, 81, 81, 82, 83, 84, 84, 85, 87, 
+			87, 87, 88, 90, 91, 91, 92, 94, 94, 94, 95, 97, 98, 98, 99, 100, 
+			101, 101, 102, 104, 104, 104, 106, 107, 108, 108, 109, 111, 111, 111, 113, 114, 
+			114, 115, 116, 117, 118, 118, 119, 121, 121, 121, 123, 124, 125, 125, 126, 128
+		},
+		// 32 harmonics
+		{
+			128, 128, 129, 130, 132, 133, 134, 135, 135, 135, 136, 137, 139, 140, 141, 142, 
+			142, 142, 142, 144, 146, 147, 148, 148, 148, 149, 149, 151, 153, 154, 155, 155, 
+			155, 155, 156, 158, 160, 161, 162, 162, 162, 162, 163, 165, 167, 168, 169, 169, 
+			169, 169, 170, 172, 174, 175, 176, 176, 176, 176, 177, 179, 181, 182, 183, 182, 
+			182, 183, 184, 186, 188, 189, 190, 189, 189, 189, 191, 193, 195, 196, 196, 196, 
+			196, 196, 198, 200, 202, 204, 203, 203, 202, 203, 205, 208, 210, 211, 210, 209, 
+			208, 209, 212, 215, 218, 218, 217, 215, 214, 215, 219, 223, 226, 226, 224, 221, 
+			219, 221, 226, 232, 236, 235, 230, 224, 221, 225, 235, 248, 255, 249, 224, 181, 
+			128, 75, 32, 7, 1, 8, 21, 31, 35, 32, 26, 21, 20, 24, 30, 35, 
+			37, 35, 32, 30, 30, 33, 37, 41, 42, 41, 39, 38, 38, 41, 44, 47, 
+			48, 47, 46, 45, 46, 48, 51, 53, 54, 53, 53, 52, 54, 56, 58, 60, 
+			60, 60, 60, 60, 61, 63, 65, 67, 67, 67, 66, 67, 68, 70, 72, 73, 
+			74, 74, 73, 74, 75, 77, 79, 80, 80, 80, 80, 81, 82, 84, 86, 87, 
+			87, 87, 87, 88, 89, 91, 93, 94, 94, 94, 94, 95, 96, 98, 100, 101, 
+			101, 101, 101, 102, 103, 105, 107, 107, 108, 108, 108, 109, 110, 112, 114, 114, 
+			114, 114, 115, 116, 117, 119, 120, 121, 121, 121, 122, 123, 124, 126, 127, 128
+		},
+		// 16 harmonics
+		{
+			128, 128, 128, 129, 129, 130, 132, 134, 135, 137, 139, 140, 141, 141, 142, 142, 
+			142, 142, 142, 143, 144, 145, 146, 148, 150, 152, 153, 154, 155, 155, 156, 156, 
+			156, 156, 156, 157, 158, 159, 161, 163, 165, 166, 168, 169, 169, 169, 169, 169, 
+			169, 169, 170, 171, 172, 174, 176, 178, 180, 181, 182, 183, 183, 183, 183, 183, 
+			183, 183, 184, 185, 186, 188, 191, 193, 195, 196, 197, 198, 198, 197, 197, 196, 
+			196, 196, 197, 199, 201, 203, 206, 208, 210, 212, 213, 212, 212, 211, 209, 208, 
+			208, 208, 210, 212, 215, 219, 222, 225, 228, 229, 229, 228, 225, 222, 220, 217, 
+			217, 218, 221, 225, 232, 239, 246, 252, 255, 255, 250, 241, 226, 206, 183, 156, 
+			128, 100, 73, 50, 30, 15, 6, 1, 1, 4, 10, 17, 24, 31, 35, 38, 
+			39, 39, 36, 34, 31, 28, 27, 27, 28, 31, 34, 37, 41, 44, 46, 48, 
+			48, 48, 47, 45, 44, 44, 43, 44, 46, 48, 50, 53, 55, 57, 59, 60, 
+			60, 60, 59, 59, 58, 58, 59, 60, 61, 63, 65, 68, 70, 71, 72, 73, 
+			73, 73, 73, 73, 73, 73, 74, 75, 76, 78, 80, 82, 84, 85, 86, 87, 
+			87, 87, 87, 87, 87, 87, 88, 90, 91, 93, 95, 97, 98, 99, 100, 100, 
+			100, 100, 100, 101, 101, 102, 103, 104, 106, 108, 110, 111, 112, 113, 114, 114, 
+			114, 114, 114, 115, 115, 116, 117, 119, 121, 122, 124, 126, 127, 127, 128, 128
+		},
+		// 8 harmonics
+		{
+			128, 128, 128, 128, 128, 129, 129, 130, 131, 132, 133, 135, 137, 138, 140, 142, 
+			144, 146, 147, 149, 151, 152, 153, 154, 155, 155, 156, 156, 156, 156, 156, 156, 
+			156, 156, 156, 156, 157, 158, 158, 160, 161, 162, 164, 166, 168, 170, 172, 174, 
+			176, 178, 179, 181, 182, 183, 184, 184, 184, 184, 184, 184, 184, 184, 183, 183, 
+			183, 183, 183, 184, 185, 186, 187, 189, 191, 193, 195, 198, 200, 203, 205, 207, 
+			209, 211, 213, 214, 214, 215, 215, 214, 213, 213, 211, 210, 209, 208, 207, 207, 
+			206, 207, 207, 209, 210, 213, 216, 219, 223, 227, 232, 236, 240, 244, 248, 251, 
+			253, 255, 255, 254, 252, 248, 243, 237, 229, 220, 210, 198, 185, 172, 157, 143, 
+			128, 113, 99, 84, 71, 58, 46, 36, 27, 19, 13, 8, 4, 2, 1, 1, 
+			3, 5, 8, 12, 16, 20, 24, 29, 33, 37, 40, 43, 46, 47, 49, 49, 
+			50, 49, 49, 48, 47, 46, 45, 43, 43, 42, 41, 41, 42, 42, 43, 45, 
+			47, 49, 51, 53, 56, 58, 61, 63, 65, 67, 69, 70, 71, 72, 73, 73, 
+			73, 73, 73, 72, 72, 72, 72, 72, 72, 72, 72, 73, 74, 75, 77, 78, 
+			80, 82, 84, 86, 88, 90, 92, 94, 95, 96, 98, 98, 99, 100, 100, 100, 
+			100, 100, 100, 100, 100, 100, 100, 101, 101, 102, 103, 104, 105, 107, 109, 110, 
+			112, 114, 116, 118, 119, 121, 123, 124, 125, 126, 127, 127, 128, 128, 128, 128
+		},
+		// 4 harmonics
+		{
+			128, 128, 128, 128, 128, 128, 128, 129, 129, 129, 130, 131, 131, 132, 133, 134, 
+			135, 137, 138, 139, 141, 143, 144, 146, 148, 150, 152, 154, 156, 159, 161, 163, 
+			165, 167, 169, 171, 173, 174, 176, 177, 179, 180, 181, 182, 183, 184, 185, 185, 
+			186, 186, 186, 186, 186, 186, 186, 186, 185, 185, 185, 184, 184, 184, 184, 183, 
+			183, 184, 184, 184, 184, 185, 186, 187, 188, 189, 190, 192, 194, 196, 198, 200, 
+			203, 205, 208, 211, 214, 217, 220, 223, 226, 229, 232, 235, 238, 241, 243, 246, 
+			248, 250, 252, 253, 254, 255, 255, 255, 255, 254, 252, 251, 249, 246, 243, 240, 
+			236, 231, 227, 221, 216, 210, 204, 197, 190, 183, 176, 168, 160, 152, 144, 136, 
+			128, 120, 112, 104, 96, 88, 80, 73, 66, 59, 52, 46, 40, 35, 29, 25, 
+			20, 16, 13, 10, 7, 5, 4, 2, 1, 1, 1, 1, 2, 3, 4, 6, 
+			8, 10, 13, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45, 48, 51, 
+			53, 56, 58, 60, 62, 64, 66, 67, 68, 69, 70, 71, 72, 72, 72, 72, 
+			73, 73, 72, 72, 72, 72, 71, 71, 71, 70, 70, 70, 70, 70, 70, 70, 
+			70, 71, 71, 72, 73, 74, 75, 76, 77, 79, 80, 82, 83, 85, 87, 89, 
+			91, 93, 95, 97, 100, 102, 104, 106, 108, 110, 112, 113, 115, 117, 118, 119, 
+			121, 122, 123, 124, 125, 125, 126, 127, 127, 127, 128, 128, 128, 128, 128, 128
+		},
+		// 2 harmonics
+		{
+			128, 128, 128, 128, 128, 128, 128, 128, 128, 129, 129, 129, 129, 130, 130, 130, 
+			131, 131, 132, 133, 133, 134, 135, 136, 137, 138, 139, 141, 142, 144, 145, 147, 
+			148, 150, 152, 154, 156, 158, 160, 162, 164, 166, 169, 171, 174, 176, 179, 181, 
+			184, 186, 189, 192, 194, 197, 200, 202, 205, 208, 211, 213, 216, 218, 221, 223, 
+			226, 228, 230, 233, 235, 237, 239, 241, 243, 244, 246, 247, 249, 250, 251, 252, 
+			253, 254, 254, 255, 255, 255, 255, 255, 254, 254, 253, 252, 252, 250, 249, 248, 
+			246, 244, 242, 240, 238, 236, 233, 230, 227, 224, 221, 218, 215, 211, 208, 204, 
+			200, 196, 192, 188, 184, 179, 175, 170, 166, 161, 157, 152, 147, 142, 138, 133, 
+			128, 123, 118, 114, 109, 104, 99, 95, 90, 86, 81, 77, 72, 68, 64, 60, 
+			56, 52, 48, 45, 41, 38, 35, 32, 29, 26, 23, 20, 18, 16, 14, 12, 
+			10, 8, 7, 6, 4, 4, 3, 2, 2, 1, 1, 1, 1, 1, 2, 2, 
+			3, 4, 5, 6, 7, 9, 10, 12, 13, 15, 17, 19, 21, 23, 26, 28, 
+			30, 33, 35, 38, 40, 43, 45, 48, 51, 54, 56, 59, 62, 64, 67, 70, 
+			72, 75, 77, 80, 82, 85, 87, 90, 92, 94, 96, 98, 100, 102, 104, 106, 
+			108, 109, 111, 112, 114, 115, 117, 118, 119, 120, 121, 122, 123, 123, 124, 125, 
+			125, 126, 126, 126, 127, 127, 127, 127, 128, 128, 128, 128, 128, 128, 128, 128
+		},
+		// 1 harmonics
+		{
+			128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174, 
+			177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211, 213, 216, 
+			218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240, 241, 243, 244, 
+			245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255, 
+			255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246, 
+			245, 244, 243, 241, 240, 239, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220, 
+			218, 216, 213, 211, 209, 206, 204, 201, 199, 196, 193, 191, 188, 185, 182, 179, 
+			177, 174, 171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 140, 137, 134, 131, 
+			128, 125, 122, 119, 116, 112, 109, 106, 103, 100, 97, 94, 91, 88, 85, 82, 
+			79, 77, 74, 71, 68, 65, 63, 60, 57, 55, 52, 50, 47, 45, 43, 40, 
+			38, 36, 34, 32, 30, 28, 26, 24, 22, 21, 19, 17, 16, 15, 13, 12, 
+			11, 10, 8, 7, 6, 6, 5, 4, 3, 3, 2, 2, 2, 1, 1, 1, 
+			1, 1, 1, 1, 2, 2, 2, 3, 3, 4, 5, 6, 6, 7, 8, 10, 
+			11, 12, 13, 15, 16, 17, 19, 21, 22, 24, 26, 28, 30, 32, 34, 36, 
+			38, 40, 43, 45, 47, 50, 52, 55, 57, 60, 63, 65, 68, 71, 74, 77, 
+			79, 82, 85, 88, 91, 94, 97, 100, 103, 106, 109, 112, 116, 119, 122, 125
+		},
+	},
+};
@@ -86,12 +86,14 @@ const SYNTH_TRACK tracks[] PROGMEM = {
 		.notes = track1_notes,
 		.timeOffsets = track1_timeOffsets,
 		.noteCount = 384,
+		.flags = 0,
 	},
 	// TRACK 2
 	{
 		.notes = track2_notes,
 		.timeOffsets = track2_timeOffsets,
 		.noteCount = 120,
+		.flags = 0,
 	},
 };
 
@@ -254,18 +254,21 @@ const SYNTH_TRACK tracks[] PROGMEM = {
 		.notes = track1_notes,
 		.timeOffsets = track1_timeOffsets,
 		.noteCount = 598,
+		.flags = 0,
 	},
 	// TRACK 2
 	{
 		.notes = track2_notes,
 		.timeOffsets = track2_timeOffsets,
 		.noteCount = 622,
+		.flags = 0,
 	},
 	// TRACK 3
 	{
 		.notes = track3_notes,
 		.timeOffsets = track3_timeOffsets,
 		.noteCount = 582,
+		.flags = 0,
 	},
 };
 
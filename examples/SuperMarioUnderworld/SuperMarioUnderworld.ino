@@ -46,12 +46,14 @@ const SYNTH_TRACK tracks[] PROGMEM = {
 		.notes = track1_notes,
 		.timeOffsets = track1_timeOffsets,
 		.noteCount = 90,
+		.flags = 0,
 	},
 	// TRACK 2
 	{
 		.notes = track2_notes,
 		.timeOffsets = track2_timeOffsets,
 		.noteCount = 90,
+		.flags = 0,
 	},
 };
 
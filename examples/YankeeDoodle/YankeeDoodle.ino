@@ -23,6 +23,7 @@ const SYNTH_TRACK tracks[] PROGMEM = {
 		.notes = track1_notes,
 		.timeOffsets = track1_timeOffsets,
 		.noteCount = 56,
+		.flags = 0,
 	},
 };
 
@@ -0,0 +1,37 @@
+/*
+	Replacement of <Arduino.h> for compiling Synth.cpp on the PC. It is used
+	by "render.cpp". Only what the synthesizer needs is declared here.
+
+	Every render thread has its own SynthClass instance. So the registers
+	written by the synthesizer are thread local and every instance writes its
+	samples to the OCR2B of its own thread.
+*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define OUTPUT	1
+#define TOIE2	0
+#define UCSZ00	1
+#define UCSZ01	2
+#define TXEN0	3
+#define UDRE0	5
+
+#define _BV(bit)			(1 << (bit))
+#define _SFR_BYTE(sfr)	(sfr)
+
+extern thread_local uint8_t SREG, TCCR2A, TCCR2B, TIMSK2, OCR2A, OCR2B;
+extern thread_local uint8_t UBRR0H, UBRR0L, UCSR0A, UCSR0B, UCSR0C, UDR0;
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void delay(unsigned long) {}
+
+#endif
@@ -0,0 +1,14 @@
+/*
+	Replacement of <avr/interrupt.h> for compiling Synth.cpp on the PC. There
+	are no interrupts. The renderer calls "handleIsr" itself.
+*/
+
+#ifndef HOST_INTERRUPT_H
+#define HOST_INTERRUPT_H
+
+#define cli()
+#define sei()
+
+#define ISR(vector, ...)	extern "C" void vector(void)
+
+#endif
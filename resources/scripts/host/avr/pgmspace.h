@@ -0,0 +1,21 @@
+/*
+	Replacement of <avr/pgmspace.h> for compiling Synth.cpp on the PC.
+
+	On the PC program memory is ordinary memory so reading from it is a plain
+	memory access. "pgm_read_word" also gets used for reading pointers which
+	have 16 bit on the AVR but 64 bit on the PC. So it returns the addressed
+	object as it is.
+*/
+
+#ifndef HOST_PGMSPACE_H
+#define HOST_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+
+#define pgm_read_byte(address)	(*(const uint8_t *)(address))
+#define pgm_read_word(address)	(*(address))
+#define pgm_read_dword(address)	((uint32_t)*(address))
+
+#endif
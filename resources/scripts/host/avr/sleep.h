@@ -0,0 +1,13 @@
+/*
+	Replacement of <avr/sleep.h> for compiling Synth.cpp on the PC.
+*/
+
+#ifndef HOST_SLEEP_H
+#define HOST_SLEEP_H
+
+#define SLEEP_MODE_IDLE	0
+
+#define set_sleep_mode(mode)
+#define sleep_mode()
+
+#endif
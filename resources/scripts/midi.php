@@ -13,6 +13,12 @@
 // the PC (gcc) or Arduino.
 $PC = FALSE;
 
+// A checkpoint (state of all tracks) gets generated every this many
+// ticks and at every marker. Checkpoints allow to seek within a song
+// and to loop parts of it. Smaller values make seeking faster but
+// require more program memory (28 bytes per checkpoint).
+$checkpointInterval = 1024;
+
 class HighNibbleException extends \Exception {};
 class MultiNoteException extends \Exception {};
 
@@ -470,17 +476,162 @@ function getTempo($events) {
 	return $value;
 }
 
+/**
+ * Converts a pitch wheel value (0 - 16383, center 8192) to a pitch bend in
+ * 1/16 semitones as used by the pitch bend events of the synthesizer. The
+ * usual pitch bend range of +/-2 semitones is assumed.
+ */
+function getPitchBend($pitch) {
+	$bend = intval(round(($pitch - 8192) * 32 / 8192));
+	return max(-32, min(31, $bend));
+}
+
+function getMarkers($events) {
+	$markers = array();
+	$time = 0;
+	foreach ($events as $event) {
+		$time += $event['delta-time'];
+		if ($event['type'] === 'meta' && ($event['meta'] === 'marker' || $event['meta'] === 'cue-point')) {
+			$markers[$time] = preg_replace('/[^\x20-\x7E]/', '', $event['data']);
+		}
+	}
+	return $markers;
+}
+
+/**
+ * Inserts the markers as marker events into the notes of a track. Markers
+ * occuring at the same tick as a note get inserted in front of it. Markers
+ * after the last note of the track get dropped as the track would end later
+ * otherwise. The markers get numbered in the order they occur.
+ */
+function addMarkers($notes, $markers) {
+	$result = array();
+	$markerTicks = array_slice(array_keys($markers), 0, 32);
+	$number = 0;
+	$time = 0;
+	$lastTime = 0;
+	foreach ($notes as $note) {
+		$time += $note['delta-time'];
+		while ($number < count($markerTicks) && $markerTicks[$number] <= $time) {
+			$result[] = array(
+				'type' => 'marker',
+				'delta-time' => $markerTicks[$number] - $lastTime,
+				'marker' => $number,
+			);
+			$lastTime = $markerTicks[$number];
+			$number++;
+		}
+		$note['delta-time'] = $time - $lastTime;
+		$result[] = $note;
+		$lastTime = $time;
+	}
+	return $result;
+}
+
+/**
+ * Simulates SynthClass::handleTick() for all tracks and records the state
+ * of each track every $interval ticks and at every marker. The generated
+ * values must match exactly the ones calculated by the Arduino code.
+ */
+function getCheckpoints($tracksWithNotes, $interval, $markers) {
+	$checkpoints = array();
+	$states = array();
+	foreach ($tracksWithNotes as $track => $notes) {
+		$states[$track] = array(
+			'index' => 0,
+			'duration' => 0,
+			'note' => 0x80,
+			'bend' => 0,
+		);
+	}
+	for ($tick = 0; ; $tick++) {
+		$finishedTracks = 0;
+		foreach ($tracksWithNotes as $track => $notes) {
+			$index = $states[$track]['index'];
+			$duration = $states[$track]['duration'];
+			$note = $states[$track]['note'];
+			$bend = $states[$track]['bend'];
+			$noteCount = count($notes);
+			if ($index >= $noteCount) {
+				$note = 0x80;
+				$duration = 0;
+				$finishedTracks++;
+			} else {
+				$trackStart = ($duration == 0);
+				if ($duration) {
+					$duration--;
+				}
+				while ($duration == 0) {
+					if ($trackStart) {
+						$note = 0x80;
+						$trackStart = FALSE;
+					} elseif ($notes[$index]['type'] === 'pitch-bend') {
+						// A pitch bend event keeps the note playing
+						$bend = $notes[$index]['bend'];
+						$index++;
+					} elseif ($notes[$index]['type'] === 'marker') {
+						// A marker event only gets reported
+						$index++;
+					} else {
+						$note = ($notes[$index]['type'] === 'note-on') ? $notes[$index]['note'] : 0x80;
+						$index++;
+					}
+					if ($index >= $noteCount) {
+						// The track will get finished with the next tick
+						$duration = 0;
+						break;
+					}
+					$duration = $notes[$index]['delta-time'];
+				}
+			}
+			$states[$track] = array(
+				'index' => $index,
+				'duration' => $duration,
+				'note' => $note,
+				'bend' => $bend,
+			);
+		}
+		if ($finishedTracks >= count($tracksWithNotes)) {
+			break;
+		}
+		if ($tick && (!($tick % $interval) || isset($markers[$tick]))) {
+			$checkpoints[] = array(
+				'tick' => $tick,
+				'states' => $states,
+			);
+		}
+	}
+	return $checkpoints;
+}
+
 function splitNotes($events) {
 	$notes = array();
 	$currentNote = array();
 	$time = 0;
 	$debugEvents = array();
 	$useChannel = NULL;
+	$currentBend = 0;
 	foreach ($events as $event) {
 		$debugEvents[] = $event;
 		$time += $event['delta-time'];
 
 		if ($event['type'] === 'midi') {
+			if ($event['midi'] === 'pitch-wheel-change') {
+				// The pitch wheel affects all notes of the channel. So it gets
+				// added to every track the notes have been split up into.
+				$bend = getPitchBend($event['pitch']);
+				if ($bend !== $currentBend) {
+					foreach (array_keys($notes) as $splitIndex) {
+						$notes[$splitIndex][] = array(
+							'type' => 'pitch-bend',
+							'abs-time' => $time,
+							'bend' => $bend,
+						);
+					}
+					$currentBend = $bend;
+				}
+				continue;
+			}
 			$useIndex = NULL;
 			if ($event['midi'] === 'note-on') {
 				if ($event['velocity'] == 0) {
@@ -523,6 +674,15 @@ function splitNotes($events) {
 				if ($useIndex === NULL) {
 					throw new \Exception('This shouldn\'t happen!');
 				}
+				if (!isset($notes[$useIndex]) && $currentBend !== 0) {
+					// A new split track starts with the current pitch bend of the
+					// channel. This also keeps a bend received before the first note.
+					$notes[$useIndex][] = array(
+						'type' => 'pitch-bend',
+						'abs-time' => $time,
+						'bend' => $currentBend,
+					);
+				}
 				$notes[$useIndex][] = array(
 					'type' => $event['midi'],
 					'abs-time' => $time,
@@ -546,11 +706,25 @@ function splitNotes($events) {
 function filterNotes($events) {
 	$notes = array();
 	$currentNote = NULL;
+	$currentBend = 0;
 	$time = 0;
 	foreach ($events as $event) {
 		$time += $event['delta-time'];
 
 		if ($event['type'] === 'midi') {
+			if ($event['midi'] === 'pitch-wheel-change') {
+				$bend = getPitchBend($event['pitch']);
+				if ($bend !== $currentBend) {
+					$notes[] = array(
+						'type' => 'pitch-bend',
+						'delta-time' => $time,
+						'bend' => $bend,
+						'channel' => $event['channel'],
+					);
+					$time = 0;
+					$currentBend = $bend;
+				}
+			}
 			if ($event['midi'] === 'note-on') {
 				if ($event['note'] === $currentNote && $event['velocity'] == 0) {
 					$event['midi'] = 'note-off';
@@ -599,9 +773,12 @@ if ($header['data']['division'] & 0x8000) {
 
 
 $noteCounts = array();
+$trackFlags = array();
 
 $useTempo = NULL;
 
+$markers = array();
+
 
 echo "
 #include <avr/pgmspace.h>
@@ -636,6 +813,8 @@ for ($track = 0; $track < $header['data']['tracks']; $track++) {
 		echo "// ERROR: " . $e->getMessage()."\n";
 	}
 
+	$markers = $markers + getMarkers($trackChunk['data']);
+
 	if ($track > 0) {
 
 		try {
@@ -657,6 +836,11 @@ for ($track = 0; $track < $header['data']['tracks']; $track++) {
 	}
 }
 
+// The markers get reported as SYNTH__EVENT_MARKER events by the first track
+ksort($markers);
+if (count($markers) && count($tracksWithNotes)) {
+	$tracksWithNotes[0] = addMarkers($tracksWithNotes[0], $markers);
+}
 
 foreach ($tracksWithNotes as $track => $notes) {
 	$trackNumber = $track+1;
@@ -671,6 +855,7 @@ foreach ($tracksWithNotes as $track => $notes) {
 	}
 
 	$noteCount = 0;
+	$trackFlags[$track] = array();
 	foreach ($notes as $index => $note) {
 		if (!($index % 16)) {
 			$noteCode .= chr(10) . chr(9);
@@ -678,6 +863,12 @@ foreach ($tracksWithNotes as $track => $notes) {
 		}
 		if ($note['type'] === 'note-on') {
 			$noteCode .= $note['note'] . ', ';
+		} elseif ($note['type'] === 'pitch-bend') {
+			$noteCode .= (0xE0 + $note['bend']) . ', ';
+			$trackFlags[$track]['SYNTH__TRACK_PITCH_BEND'] = TRUE;
+		} elseif ($note['type'] === 'marker') {
+			$noteCode .= (0xA0 + $note['marker']) . ', ';
+			$trackFlags[$track]['SYNTH__TRACK_MARKERS'] = TRUE;
 		} else {
 			$noteCode .= 0x80 . ', ';
 		}
@@ -706,12 +897,47 @@ foreach ($noteCounts as $track => $noteCount) {
 	echo "\t\t.notes = track".$trackNumber."_notes,\n";
 	echo "\t\t.timeOffsets = track".$trackNumber."_timeOffsets,\n";
 	echo "\t\t.noteCount = ".$noteCount.",\n";
+	// Always initialize all fields to avoid "missing initializer" warnings
+	echo "\t\t.flags = ".(count($trackFlags[$track]) ? implode(' | ', array_keys($trackFlags[$track])) : '0').",\n";
 	echo "\t},\n";
 }
 echo "};".chr(10);
 
+$checkpoints = getCheckpoints(array_slice($tracksWithNotes, 0, 4), $checkpointInterval, $markers);
+
+echo "\n// Checkpoint index used by Synth.seek() and Synth.setLoop(). It is only valid\n";
+echo "// as long as the first four entries of the \"tracks\" array are left unchanged.\n";
+$number = 0;
+foreach ($markers as $tick => $marker) {
+	echo "// Marker ".($number < 32 ? $number : '-')." \"".$marker."\" at tick ".$tick."\n";
+	$number++;
+}
+if (count($checkpoints)) {
+	echo "const SYNTH_CHECKPOINT checkpoints[] PROGMEM = {".chr(10);
+	foreach ($checkpoints as $checkpoint) {
+		$indexCode = array();
+		$durationCode = array();
+		$noteCode = array();
+		$bendCode = array();
+		foreach ($checkpoint['states'] as $state) {
+			$indexCode[] = $state['index'];
+			$durationCode[] = $state['duration'];
+			$noteCode[] = $state['note'];
+			$bendCode[] = $state['bend'];
+		}
+		echo "\t{ ".$checkpoint['tick'].", { ".implode(', ', $indexCode)." }, { ".implode(', ', $durationCode)." }, { ".implode(', ', $noteCode)." }, { ".implode(', ', $bendCode)." } },\n";
+	}
+	echo "};".chr(10);
+	$playArguments = ", checkpoints, ".count($checkpoints);
+} else {
+	$playArguments = "";
+}
+
 $microsecondsPerQuarterNote = $useTempo = 600000;
 
+echo "\n// Ticks per quarter note. Needed for sending or following a MIDI clock.\n";
+echo "const word ticksPerQuarterNote = ".(int)$ticksPerQuarterNote.";\n";
+
 // echo "// Microseconds per quarter note: ".$microsecondsPerQuarterNote."\n";
 
 $microsecondsPerTick = $microsecondsPerQuarterNote / $ticksPerQuarterNote;
@@ -724,12 +950,13 @@ echo "
 
 void setup() {
 	Synth.init(3);
+	// Synth.setClock(SYNTH__CLOCK_OUTPUT, ticksPerQuarterNote);
 }
 
 void loop() {
 	if (!Synth.isPlaying()) {
 		delay(1000);
-		Synth.play(tracks, ".$cnt.", ".$samplesPerTick.");
+		Synth.play(tracks, ".$cnt.", ".$samplesPerTick.$playArguments.");
 	} else {
 		// Do something. ~3/5 ths of the CPU cycles are still available.
 	}
@@ -0,0 +1,618 @@
+/**
+ * Renders songs on the PC using the real synthesizer code (Synth.cpp) so a
+ * whole library of converted songs can get checked at once. The songs are
+ * the sketches generated by "midi.php". Every song gets rendered by its own
+ * SynthClass instance and the songs get rendered in parallel by a pool of
+ * threads.
+ *
+ * You can compile it under Linux using:
+ *
+ * g++ -O2 -pthread -DF_CPU=16000000L -D__AVR_ATmega328P__ -Ihost -I../.. -o render render.cpp ../../Synth.cpp
+ *
+ * The directory "host" contains replacements of the Arduino headers. Call it
+ * with the sketches to render:
+ *
+ * ./render [-j threads] [-o directory] [-c] [-f clock] [-q ticks] ../../examples/YankeeDoodle/YankeeDoodle.ino ...
+ *
+ * A WAV file (8 bit, mono, at the sampling frequency selected for the song)
+ * gets written for every sketch into the given directory. When all songs are
+ * done a line of statistics gets printed for every song:
+ *
+ *  - The duration of the song
+ *  - The sampling frequency selected for the song
+ *  - The maximum number of oscillators sounding at once
+ *  - The number of samples at the limits of the output range (0 or 255).
+ *    The mixer divides by the number of oscillators so the output can not
+ *    clip. Many samples at a limit only show that the output is loud.
+ *  - The average and peak CPU load of the ISR on an ATmega328P at 16 MHz.
+ *    It is estimated by "getCycles" using the SYNTH__CYCLES_* values of
+ *    Synth.h.
+ *
+ * The exit code is 1 if any sketch could not get rendered.
+ *
+ * The MIDI clock can get tested using two more options. "-c" sends a MIDI
+ * clock and writes the bytes sent on the UART into a ".clock" file next to
+ * the WAV file. Every line holds the time in microseconds since "play" and
+ * the byte in hex. "-f file" follows the MIDI clock recorded in such a file
+ * instead of using the tempo of the songs. The ticks per quarter note are
+ * taken from the sketch or from "-q ticks" (96 by default).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Synth.h>
+
+// Songs get stopped after this time (in seconds) in case they loop
+#define RENDER__MAX_SECONDS		900
+
+// Size of the file buffer used for writing the WAV files
+#define RENDER__WRITE_BUFFER		( 1 << 20 )
+
+// CPU cycles per PWM period (16 MHz / 62.5 kHz)
+#define RENDER__CYCLES_PER_PWM	256
+
+// Microseconds per PWM period (1 / 62.5 kHz)
+#define RENDER__MICROSECONDS_PER_PWM	16
+
+// PWM periods the UART needs for sending a byte (10 bits at 31250 baud)
+#define RENDER__PWM_PER_MIDI_BYTE		20
+
+thread_local uint8_t SREG, TCCR2A, TCCR2B, TIMSK2, OCR2A, OCR2B;
+thread_local uint8_t UBRR0H, UBRR0L, UCSR0A, UCSR0B, UCSR0C, UDR0;
+
+// A byte sent or received on the MIDI port and its time in PWM periods
+typedef struct _RENDER_MIDI_BYTE
+{
+	unsigned long time;
+	byte data;
+} RENDER_MIDI_BYTE;
+
+typedef struct _RENDER_OPTIONS
+{
+	std::string directory;
+	bool clockOutput;
+	std::vector<RENDER_MIDI_BYTE> clock;
+	word ticksPerQuarterNote;
+} RENDER_OPTIONS;
+
+typedef struct _RENDER_SONG
+{
+	std::string file;
+	std::string error;
+	std::map<std::string, std::vector<long> > arrays;
+	std::map<std::string, std::vector<byte> > notes;
+	std::map<std::string, std::vector<word> > timeOffsets;
+	std::vector<SYNTH_TRACK> tracks;
+	byte trackCount;
+	word samplesPerTick;
+	word ticksPerQuarterNote;
+
+	// Statistics
+	unsigned long samples;
+	word sampleRate;
+	byte peakVoices;
+	unsigned long atLimit;
+	double averageLoad;
+	double peakLoad;
+} RENDER_SONG;
+
+/**
+ * Removes all comments from the source code of a sketch.
+ *
+ * @param const std::string &source: The source code
+ * @return std::string The source code without comments
+ */
+std::string stripComments(const std::string &source) {
+	std::string result;
+	size_t i = 0;
+
+	while (i < source.size()) {
+		if (source.compare(i, 2, "//") == 0) {
+			while (i < source.size() && source[i] != '\n') {
+				i++;
+			}
+		} else if (source.compare(i, 2, "/*") == 0) {
+			i = source.find("*/", i + 2);
+			i = (i == std::string::npos) ? source.size() : i + 2;
+			result += ' ';
+		} else {
+			result += source[i++];
+		}
+	}
+	return result;
+}
+
+/**
+ * Removes leading and trailing whitespace.
+ *
+ * @param const std::string &text: The text to trim
+ * @return std::string The trimmed text
+ */
+std::string trim(const std::string &text) {
+	size_t start = text.find_first_not_of(" \t\r\n");
+	size_t end = text.find_last_not_of(" \t\r\n");
+
+	if (start == std::string::npos) {
+		return "";
+	}
+	return text.substr(start, end - start + 1);
+}
+
+/**
+ * Splits a list at every separator.
+ *
+ * @param const std::string &text: The list
+ * @param char separator: The separator
+ * @return std::vector<std::string> The trimmed items of the list
+ */
+std::vector<std::string> split(const std::string &text, char separator) {
+	std::vector<std::string> items;
+	size_t start = 0;
+	size_t end;
+
+	do {
+		end = text.find(separator, start);
+		items.push_back(trim(text.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+		start = end + 1;
+	} while (end != std::string::npos);
+	return items;
+}
+
+/**
+ * Returns the position of the brace closing the one at "start".
+ *
+ * @param const std::string &source: The source code
+ * @param size_t start: The position of the opening brace
+ * @return size_t The position of the closing brace or std::string::npos
+ */
+size_t findClosingBrace(const std::string &source, size_t start) {
+	int depth = 0;
+
+	for (size_t i = start; i < source.size(); i++) {
+		if (source[i] == '{') {
+			depth++;
+		} else if (source[i] == '}' && --depth == 0) {
+			return i;
+		}
+	}
+	return std::string::npos;
+}
+
+/**
+ * Evaluates the "flags" of a track like "SYNTH__TRACK_PITCH_BEND | 2".
+ *
+ * @param const std::string &value: The flags as written in the sketch
+ * @return byte The value of the flags
+ */
+byte parseFlags(const std::string &value) {
+	byte flags = 0;
+
+	for (const std::string &flag : split(value, '|')) {
+		if (flag == "SYNTH__TRACK_PITCH_BEND") {
+			flags |= SYNTH__TRACK_PITCH_BEND;
+		} else if (flag == "SYNTH__TRACK_MARKERS") {
+			flags |= SYNTH__TRACK_MARKERS;
+		} else {
+			flags |= (byte)strtol(flag.c_str(), NULL, 0);
+		}
+	}
+	return flags;
+}
+
+/**
+ * Parses the "SYNTH_TRACK" array of a sketch. The notes and time offsets of
+ * the tracks are copied from the arrays found before so they have the types
+ * the synthesizer expects.
+ *
+ * @param RENDER_SONG *song: The song to add the tracks to
+ * @param const std::string &body: The initializer of the array without braces
+ * @return bool Returns FALSE if a track references an unknown array
+ */
+bool parseTracks(RENDER_SONG *song, const std::string &body) {
+	size_t start = 0;
+	size_t end;
+
+	while ((start = body.find('{', start)) != std::string::npos) {
+		end = findClosingBrace(body, start);
+		if (end == std::string::npos) {
+			break;
+		}
+		std::vector<std::string> fields = split(body.substr(start + 1, end - start - 1), ',');
+		std::string names[4] = { ".notes", ".timeOffsets", ".noteCount", ".flags" };
+		std::string values[4];
+		for (size_t i = 0; i < fields.size() && i < 4; i++) {
+			size_t equals = fields[i].find('=');
+			if (equals == std::string::npos) {
+				// Positional initializer
+				values[i] = fields[i];
+				continue;
+			}
+			for (int j = 0; j < 4; j++) {
+				if (trim(fields[i].substr(0, equals)) == names[j]) {
+					values[j] = trim(fields[i].substr(equals + 1));
+				}
+			}
+		}
+		if (!song->arrays.count(values[0]) || !song->arrays.count(values[1])) {
+			song->error = "Unknown notes or time offsets array \"" + values[0] + "\"";
+			return false;
+		}
+		std::vector<byte> &notes = song->notes[values[0]];
+		std::vector<word> &timeOffsets = song->timeOffsets[values[1]];
+		notes.assign(song->arrays[values[0]].begin(), song->arrays[values[0]].end());
+		timeOffsets.assign(song->arrays[values[1]].begin(), song->arrays[values[1]].end());
+		word noteCount = values[2].empty() ? notes.size() : (word)strtol(values[2].c_str(), NULL, 0);
+		if (noteCount > notes.size() || noteCount > timeOffsets.size()) {
+			song->error = "Note count exceeds the arrays of track \"" + values[0] + "\"";
+			return false;
+		}
+		song->tracks.push_back(SYNTH_TRACK { notes.data(), timeOffsets.data(), noteCount, parseFlags(values[3]) });
+		start = end + 1;
+	}
+	return true;
+}
+
+/**
+ * Parses a sketch generated by "midi.php". All arrays of numbers get read.
+ * The tracks and the tick length are taken from the "Synth.play" call.
+ *
+ * @param RENDER_SONG *song: The song whose "file" to parse
+ * @return bool Returns FALSE and sets "error" if the sketch can't get used
+ */
+bool parseSketch(RENDER_SONG *song) {
+	FILE *file = fopen(song->file.c_str(), "rb");
+	std::string source;
+	std::string tracksName;
+	std::map<std::string, std::string> trackArrays;
+	char buffer[4096];
+	size_t length;
+	size_t position = 0;
+
+	if (!file) {
+		song->error = "Can't open file";
+		return false;
+	}
+	while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		source.append(buffer, length);
+	}
+	fclose(file);
+	source = stripComments(source);
+
+	// Every "name[] = { ... }" is an array
+	while ((position = source.find("[]", position)) != std::string::npos) {
+		size_t nameEnd = source.find_last_not_of(" \t\r\n", position - 1) + 1;
+		size_t nameStart = nameEnd;
+		while (nameStart > 0 && (isalnum(source[nameStart - 1]) || source[nameStart - 1] == '_')) {
+			nameStart--;
+		}
+		size_t typeStart = source.find_last_of(";}", nameStart);
+		typeStart = (typeStart == std::string::npos) ? 0 : typeStart + 1;
+		std::string name = source.substr(nameStart, nameEnd - nameStart);
+		std::string type = source.substr(typeStart, nameStart - typeStart);
+		size_t open = source.find('{', position);
+		size_t close = (open == std::string::npos) ? open : findClosingBrace(source, open);
+		if (close == std::string::npos) {
+			break;
+		}
+		std::string body = source.substr(open + 1, close - open - 1);
+		if (type.find("SYNTH_TRACK") != std::string::npos) {
+			trackArrays[name] = body;
+		} else if (body.find('{') == std::string::npos) {
+			std::vector<long> &values = song->arrays[name];
+			for (const std::string &value : split(body, ',')) {
+				if (!value.empty()) {
+					values.push_back(strtol(value.c_str(), NULL, 0));
+				}
+			}
+		}
+		position = close;
+	}
+
+	// The value of "ticksPerQuarterNote" written by "midi.php"
+	position = source.find("ticksPerQuarterNote =");
+	if (position != std::string::npos) {
+		song->ticksPerQuarterNote = strtol(source.c_str() + position + strlen("ticksPerQuarterNote ="), NULL, 0);
+	}
+
+	// The arguments of "Synth.play(tracks, trackCount, samplesPerTick, ...)"
+	position = source.find("Synth.play(");
+	if (position == std::string::npos) {
+		song->error = "No call of Synth.play found";
+		return false;
+	}
+	position += strlen("Synth.play(");
+	std::vector<std::string> arguments = split(source.substr(position, source.find(')', position) - position), ',');
+	if (arguments.size() < 3 || !trackArrays.count(arguments[0])) {
+		song->error = "Unknown tracks passed to Synth.play";
+		return false;
+	}
+	if (!parseTracks(song, trackArrays[arguments[0]])) {
+		return false;
+	}
+	song->trackCount = strtol(arguments[1].c_str(), NULL, 0);
+	if (!song->trackCount || song->trackCount > song->tracks.size()) {
+		song->error = "Invalid track count passed to Synth.play";
+		return false;
+	}
+	song->samplesPerTick = (word)strtol(arguments[2].c_str(), NULL, 0);
+	return true;
+}
+
+/**
+ * Returns the file name of a sketch without directory and extension.
+ *
+ * @param const std::string &file: The path of the sketch
+ * @return std::string The name of the song
+ */
+std::string getSongName(const std::string &file) {
+	size_t start = file.find_last_of('/');
+	std::string name = file.substr(start == std::string::npos ? 0 : start + 1);
+	return name.substr(0, name.find_last_of('.'));
+}
+
+/**
+ * Writes a little endian value of the given number of bytes into a buffer.
+ *
+ * @param byte *buffer: Where to write the value
+ * @param unsigned long value: The value
+ * @param byte bytes: The number of bytes
+ * @return void
+ */
+void putLittleEndian(byte *buffer, unsigned long value, byte bytes) {
+	while (bytes--) {
+		*buffer++ = value & 0xFF;
+		value >>= 8;
+	}
+}
+
+/**
+ * Writes 8-bit mono samples as a WAV file.
+ *
+ * @param const std::string &file: The name of the WAV file
+ * @param const std::vector<byte> &samples: The samples
+ * @param word sampleRate: The number of samples per second
+ * @return bool Returns FALSE if the file couldn't get written
+ */
+bool writeWav(const std::string &file, const std::vector<byte> &samples, word sampleRate) {
+	byte header[44];
+	FILE *wav = fopen(file.c_str(), "wb");
+	bool success;
+
+	if (!wav) {
+		return false;
+	}
+	setvbuf(wav, NULL, _IOFBF, RENDER__WRITE_BUFFER);
+	memcpy(header, "RIFF....WAVEfmt ", 16);
+	putLittleEndian(header + 4, 36 + samples.size(), 4);
+	putLittleEndian(header + 16, 16, 4);				// Size of the format chunk
+	putLittleEndian(header + 20, 1, 2);					// PCM
+	putLittleEndian(header + 22, 1, 2);					// Mono
+	putLittleEndian(header + 24, sampleRate, 4);
+	putLittleEndian(header + 28, sampleRate, 4);		// Bytes per second
+	putLittleEndian(header + 32, 1, 2);					// Bytes per sample
+	putLittleEndian(header + 34, 8, 2);					// Bits per sample
+	memcpy(header + 36, "data", 4);
+	putLittleEndian(header + 40, samples.size(), 4);
+	success = fwrite(header, sizeof(header), 1, wav) == 1;
+	success = success && (samples.empty() || fwrite(samples.data(), samples.size(), 1, wav) == 1);
+	return (fclose(wav) == 0) && success;
+}
+
+/**
+ * Reads a MIDI clock recorded by the "-c" option.
+ *
+ * @param const char *file: The name of the file
+ * @param std::vector<RENDER_MIDI_BYTE> *clock: Receives the bytes
+ * @return bool Returns FALSE if the file can't get read
+ */
+bool readClock(const char *file, std::vector<RENDER_MIDI_BYTE> *clock) {
+	FILE *input = fopen(file, "r");
+	unsigned long microseconds;
+	unsigned int data;
+
+	if (!input) {
+		return false;
+	}
+	while (fscanf(input, "%lu %x", &microseconds, &data) == 2) {
+		clock->push_back(RENDER_MIDI_BYTE { microseconds / RENDER__MICROSECONDS_PER_PWM, (byte)data });
+	}
+	fclose(input);
+	return true;
+}
+
+/**
+ * Writes the bytes sent on the MIDI port in the format read by "readClock".
+ *
+ * @param const std::string &file: The name of the file
+ * @param const std::vector<RENDER_MIDI_BYTE> &clock: The bytes sent
+ * @return bool Returns FALSE if the file couldn't get written
+ */
+bool writeClock(const std::string &file, const std::vector<RENDER_MIDI_BYTE> &clock) {
+	FILE *output = fopen(file.c_str(), "w");
+
+	if (!output) {
+		return false;
+	}
+	setvbuf(output, NULL, _IOFBF, RENDER__WRITE_BUFFER);
+	for (const RENDER_MIDI_BYTE &midi : clock) {
+		fprintf(output, "%lu %02x\n", midi.time * RENDER__MICROSECONDS_PER_PWM, midi.data);
+	}
+	return fclose(output) == 0;
+}
+
+/**
+ * Renders a song by calling "handleIsr" of a SynthClass instance like the
+ * TIMER2 overflow interrupt would do. Every "pwmCyclesPerSample"th call has
+ * written a new sample to OCR2B which gets recorded. The CPU cycles of the
+ * ISRs of every sample period are the estimate returned by "getCycles". It
+ * includes the tick handling and interpolation like the cycle budget does.
+ *
+ * The UART is ready again RENDER__PWM_PER_MIDI_BYTE PWM periods after a byte
+ * has been written to UDR0. When following a clock the recorded bytes get
+ * passed to "midiClock" at their time. Rendering ends one second after the
+ * last of them if the song waits for more.
+ *
+ * @param RENDER_SONG *song: The parsed song
+ * @param const RENDER_OPTIONS &options: The options of the command line
+ * @return void
+ */
+void renderSong(RENDER_SONG *song, const RENDER_OPTIONS &options) {
+	SynthClass *synth = new SynthClass();
+	std::vector<byte> samples;
+	std::vector<RENDER_MIDI_BYTE> sent;
+	std::string name = options.directory + "/" + getSongName(song->file);
+	size_t received = 0;
+	unsigned long isrCount = 0;
+	unsigned long lastTick = 0;
+	unsigned long lastTickTime = 0;
+	unsigned long long totalCycles = 0;
+	word uartBusy = 0;
+	word peakCycles = 0;
+	byte cyclesPerSample;
+	byte voices;
+	word cycles;
+	byte mode = SYNTH__CLOCK_INTERNAL;
+
+	synth->init(3);
+	if (options.clockOutput) {
+		mode |= SYNTH__CLOCK_OUTPUT;
+	}
+	if (!options.clock.empty()) {
+		mode |= SYNTH__CLOCK_FOLLOW;
+	}
+	if (mode != SYNTH__CLOCK_INTERNAL) {
+		synth->setClock(mode, song->ticksPerQuarterNote ? song->ticksPerQuarterNote : options.ticksPerQuarterNote);
+	}
+	UCSR0A = _BV(UDRE0);
+	UDR0 = 0;
+	synth->play(song->tracks.data(), song->trackCount, song->samplesPerTick);
+	song->sampleRate = synth->getSampleRate();
+	cyclesPerSample = SYNTH__PWM_FREQUENCY / song->sampleRate;
+	samples.reserve((unsigned long)song->sampleRate * 60);
+	song->peakVoices = 0;
+	song->atLimit = 0;
+	while (synth->isPlaying() && isrCount < (unsigned long)SYNTH__PWM_FREQUENCY * RENDER__MAX_SECONDS) {
+		while (received < options.clock.size() && options.clock[received].time <= isrCount) {
+			synth->midiClock(options.clock[received++].data);
+		}
+		if (UDR0) {
+			sent.push_back(RENDER_MIDI_BYTE { isrCount, UDR0 });
+			UDR0 = 0;
+			UCSR0A = 0;
+			uartBusy = RENDER__PWM_PER_MIDI_BYTE;
+		} else if (uartBusy && !--uartBusy) {
+			UCSR0A = _BV(UDRE0);
+		}
+		if (synth->getTick() != lastTick) {
+			lastTick = synth->getTick();
+			lastTickTime = isrCount;
+		} else if (received && received == options.clock.size() && isrCount - lastTickTime > SYNTH__PWM_FREQUENCY) {
+			// The song waits for a clock which will never come
+			break;
+		}
+		synth->handleIsr();
+		if (++isrCount % cyclesPerSample) {
+			continue;
+		}
+		samples.push_back(OCR2B);
+		if (OCR2B == 0 || OCR2B == 0xFF) {
+			song->atLimit++;
+		}
+		voices = synth->getVoiceCount();
+		if (voices > song->peakVoices) {
+			song->peakVoices = voices;
+		}
+		cycles = synth->getCycles();
+		totalCycles += cycles;
+		if (cycles > peakCycles) {
+			peakCycles = cycles;
+		}
+	}
+	delete synth;
+
+	song->samples = samples.size();
+	song->averageLoad = samples.empty() ? 0 : 100.0 * totalCycles / ((double)samples.size() * cyclesPerSample * RENDER__CYCLES_PER_PWM);
+	song->peakLoad = 100.0 * peakCycles / (cyclesPerSample * RENDER__CYCLES_PER_PWM);
+	if (!writeWav(name + ".wav", samples, song->sampleRate)) {
+		song->error = "Can't write WAV file";
+	}
+	if (options.clockOutput && !writeClock(name + ".clock", sent)) {
+		song->error = "Can't write clock file";
+	}
+}
+
+int main(int argc, char **argv) {
+	std::vector<RENDER_SONG> songs;
+	std::vector<std::thread> threads;
+	std::atomic<size_t> nextSong(0);
+	RENDER_OPTIONS options = { ".", false, {}, 96 };
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	int result = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			threadCount = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			options.directory = argv[++i];
+		} else if (!strcmp(argv[i], "-c")) {
+			options.clockOutput = true;
+		} else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+			if (!readClock(argv[++i], &options.clock)) {
+				fprintf(stderr, "Can't read clock file %s\n", argv[i]);
+				return 1;
+			}
+		} else if (!strcmp(argv[i], "-q") && i + 1 < argc) {
+			options.ticksPerQuarterNote = atoi(argv[++i]);
+		} else {
+			songs.push_back(RENDER_SONG());
+			songs.back().file = argv[i];
+		}
+	}
+	if (songs.empty()) {
+		fprintf(stderr, "Usage: %s [-j threads] [-o directory] [-c] [-f clock] [-q ticks] sketch.ino ...\n", argv[0]);
+		return 1;
+	}
+	if (threadCount < 1) {
+		threadCount = 1;
+	}
+
+	// Every thread takes the next song which has not been rendered yet
+	for (unsigned int i = 0; i < threadCount && i < songs.size(); i++) {
+		threads.push_back(std::thread([&songs, &nextSong, &options]() {
+			size_t index;
+			while ((index = nextSong++) < songs.size()) {
+				if (parseSketch(&songs[index])) {
+					renderSong(&songs[index], options);
+				}
+			}
+		}));
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	printf("%-32s %9s %8s %6s %8s %8s %8s\n", "Song", "Duration", "Rate", "Voices", "At limit", "Avg CPU", "Peak CPU");
+	for (const RENDER_SONG &song : songs) {
+		if (!song.error.empty()) {
+			printf("%-32s ERROR: %s\n", getSongName(song.file).c_str(), song.error.c_str());
+			result = 1;
+			continue;
+		}
+		printf("%-32s %8.2fs %6uHz %6u %8lu %7.1f%% %7.1f%%\n",
+			getSongName(song.file).c_str(),
+			(double)song.samples / song.sampleRate,
+			song.sampleRate,
+			song.peakVoices,
+			song.atLimit,
+			song.averageLoad,
+			song.peakLoad
+		);
+	}
+	return result;
+}
@@ -10,7 +10,12 @@
 // the PC (gcc) or Arduino.
 $PC = FALSE;
 
-$fSampleRate = 12500;
+// The period tables get generated for every sampling frequency the
+// synthesizer can select. See SYNTH__PWM_CYCLES_PER_SAMPLE and
+// SYNTH__MIN_PWM_CYCLES_PER_SAMPLE in Synth.h
+$fPwm = 62500;
+$pwmCyclesPerSample = 5;
+$minPwmCyclesPerSample = 2;
 
 $tableSize = 256;
 $resolutionInBits = 8;
@@ -120,7 +125,11 @@ $notes = generateNotes($notes);
 
 $midiData = midiNotes($notes);
 
-$midiData = periods($midiData, $fSampleRate, $tableSize);
+$periodTables = array();
+for ($cycles = $pwmCyclesPerSample; $cycles >= $minPwmCyclesPerSample; $cycles--) {
+	$periodTables[$cycles] = periods($midiData, $fPwm / $cycles, $tableSize);
+}
+$midiData = $periodTables[$pwmCyclesPerSample];
 
 print_r($midiData);
 exit();
@@ -139,23 +148,31 @@ foreach ($sineTable as $index => $value) {
 $sineTableCode = substr($sineTableCode, 0, -2) . chr(10) . ' };' . chr(10);
 echo $sineTableCode;
 
+$rates = count($periodTables);
 if ($PC) {
-	$periodBaseCode = 'unsigned short periodBase[128] = { ';
-	$periodFractionCode = 'unsigned char periodFraction[128] = { ';
+	$periodBaseCode = 'unsigned short periodBase[' . $rates . '][128] = {' . chr(10);
+	$periodFractionCode = 'unsigned char periodFraction[' . $rates . '][128] = {' . chr(10);
 } else {
-	$periodBaseCode = 'const word periodBase[128] PROGMEM = { ';
-	$periodFractionCode = 'const byte periodFraction[128] PROGMEM = { ';
+	$periodBaseCode = 'const word periodBase[' . $rates . '][128] PROGMEM = {' . chr(10);
+	$periodFractionCode = 'const byte periodFraction[' . $rates . '][128] PROGMEM = {' . chr(10);
 }
-foreach ($midiData['periods'] as $index => $value) {
-	if (!($index % 16)) {
-		$periodBaseCode .= chr(10) . chr(9);
-		$periodFractionCode .= chr(10) . chr(9);
+foreach ($periodTables as $cycles => $tableData) {
+	$comment = chr(9) . '// ' . round($fPwm / $cycles / 1000, 3) . ' kHz' . chr(10) . chr(9) . '{';
+	$periodBaseCode .= $comment;
+	$periodFractionCode .= $comment;
+	foreach ($tableData['periods'] as $index => $value) {
+		if (!($index % 16)) {
+			$periodBaseCode .= chr(10) . chr(9) . chr(9);
+			$periodFractionCode .= chr(10) . chr(9) . chr(9);
+		}
+		$periodBaseCode .= $value[0] . ', ';
+		$periodFractionCode .= $value[1] . ', ';
 	}
-	$periodBaseCode .= $value[0] . ', ';
-	$periodFractionCode .= $value[1] . ', ';
+	$periodBaseCode = substr($periodBaseCode, 0, -2) . chr(10) . chr(9) . '},' . chr(10);
+	$periodFractionCode = substr($periodFractionCode, 0, -2) . chr(10) . chr(9) . '},' . chr(10);
 }
-$periodBaseCode = substr($periodBaseCode, 0, -2) . chr(10) . ' };' . chr(10);
-$periodFractionCode = substr($periodFractionCode, 0, -2) . chr(10) . ' };' . chr(10);
+$periodBaseCode = substr($periodBaseCode, 0, -2) . chr(10) . '};' . chr(10);
+$periodFractionCode = substr($periodFractionCode, 0, -2) . chr(10) . '};' . chr(10);
 
 echo $periodBaseCode;
 echo $periodFractionCode;
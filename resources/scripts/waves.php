@@ -0,0 +1,102 @@
+#!/usr/bin/php
+<?php
+
+/*
+ * This script was used to generate the band-limited wave tables
+ * in "SynthWaveTables.h". Call it from the library directory:
+ *
+ * php resources/scripts/waves.php > SynthWaveTables.h
+ *
+ * Every waveform gets stored as a set of tables. Each table contains
+ * one full period of the waveform but only half as many harmonics as
+ * the table before. Synth.cpp selects the table for a note from its
+ * phase increment so no harmonic exceeds half the sampling frequency.
+ * So the tables do not depend on the sampling frequency.
+ */
+
+// The number of values per table. Smaller tables save program memory
+// but should get used together with SYNTH__INTERPOLATION. Must be a
+// power of two between 16 and 1024.
+$tableSize = 256;
+// The number of tables per waveform. Must be equal to SYNTH__WAVE_LEVELS
+// in Synth.h. The generated file checks this.
+$levels = 8;
+
+$waveforms = array(
+	'SQUARE' => 'square',
+	'SAWTOOTH' => 'sawtooth',
+);
+
+
+// Table "level" may contain harmonics up to the returned number. A table
+// of $tableSize values can not hold more than $tableSize/2 - 1 harmonics.
+function harmonics($level, $tableSize) {
+	return min($tableSize / 2 - 1, 1 << (7 - $level));
+}
+
+function waveTable($waveform, $harmonics, $tableSize) {
+	$values = array();
+	$maxVal = 0;
+	for ($index = 0; $index < $tableSize; $index++) {
+		$rad = (($index * 1.0) / $tableSize) * 2 * M_PI;
+		$value = 0;
+		for ($harmonic = 1; $harmonic <= $harmonics; $harmonic++) {
+			if ($waveform === 'square') {
+				// A square wave only consists of the odd harmonics
+				if (!($harmonic % 2)) {
+					continue;
+				}
+				$value += sin($harmonic * $rad) / $harmonic;
+			} else {
+				// A rising sawtooth consists of all harmonics with alternating sign
+				$sign = ($harmonic % 2) ? 1 : -1;
+				$value += $sign * sin($harmonic * $rad) / $harmonic;
+			}
+		}
+		$values[$index] = $value;
+		$maxVal = max($maxVal, abs($value));
+	}
+	// Normalize the values to swing from 1 to 255 around 128
+	foreach ($values as $index => $value) {
+		$values[$index] = intval(round($value / $maxVal * 127)) + 128;
+	}
+	return $values;
+}
+
+
+echo "// This file has been generated by \"resources/scripts/waves.php\". Do not edit.\n";
+echo "//\n";
+echo "// Band-limited wave tables for the waveforms other than sine. Every waveform\n";
+echo "// has " . $levels . " tables of one period each. Table N contains at most 128 >> N harmonics.\n";
+echo "\n";
+echo "// Every table has 2 ^ SYNTH__WAVE_TABLE_BITS values. To change the size set\n";
+echo "// \$tableSize in waves.php and regenerate this file.\n";
+echo "#define SYNTH__WAVE_TABLE_BITS\t" . intval(round(log($tableSize, 2))) . "\n";
+echo "\n";
+echo "// The number of tables per waveform. Set \$levels in waves.php to change it.\n";
+echo "#define SYNTH__WAVE_TABLE_LEVELS\t" . $levels . "\n";
+echo "\n";
+echo "#if SYNTH__WAVE_TABLE_LEVELS != SYNTH__WAVE_LEVELS\n";
+echo "\t#error SYNTH__WAVE_LEVELS does not match the number of generated wave tables\n";
+echo "#endif\n";
+echo "\n";
+echo "const byte SYNTH_waveTables[" . count($waveforms) . "][SYNTH__WAVE_LEVELS][1 << SYNTH__WAVE_TABLE_BITS] PROGMEM = {\n";
+foreach ($waveforms as $name => $waveform) {
+	echo "\t// " . $name . "\n";
+	echo "\t{\n";
+	for ($level = 0; $level < $levels; $level++) {
+		$harmonics = harmonics($level, $tableSize);
+		$table = waveTable($waveform, $harmonics, $tableSize);
+		echo "\t\t// " . $harmonics . " harmonics\n";
+		echo "\t\t{";
+		foreach ($table as $index => $value) {
+			if (!($index % 16)) {
+				echo chr(10) . "\t\t\t";
+			}
+			echo $value . (($index < $tableSize - 1) ? ', ' : '');
+		}
+		echo chr(10) . "\t\t},\n";
+	}
+	echo "\t},\n";
+}
+echo "};\n";